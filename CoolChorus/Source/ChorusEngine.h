@@ -0,0 +1,933 @@
+/*
+  ==============================================================================
+
+    ChorusEngine.h
+
+    The chorus DSP, shared by the float and the double processBlock.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusLFO.h"
+#include "StereoFrame.h"
+#include "DelayLine.h"
+#include "Interpolators.h"
+#include "ChorusKernels.h"
+#include "TraceZones.h"
+#include "ScopeFeed.h"
+#include "Oversampler.h"
+
+#define TYPE_CROSSFADE_TIME 0.02f //seconds a change of Type crossfades the two kernels over
+#define PARAMETER_RAMP_TIME 0.02f //seconds Dry Wet and Feedback ramp over when they change
+#define SILENCE_THRESHOLD 1.0e-5f //-100 dB, input and delay line below this count as silence
+#define LFO_BLOCK_SIZE 256 //longest sub-block the kernel renders in one pass
+#define MAX_VOICES 8
+#define MAX_CHANNELS 16 //enough for 7.1.4 and 9.1.6
+
+//==============================================================================
+/**
+    The Quality parameter. Live reads with the Interpolation parameter's mode
+    at the host's precision, Render raises the polynomial modes to the 6 point
+    Lagrange and processes in double, Auto is Render while the host renders
+    offline. The precision is picked in prepareToPlay, so the parameter is not
+    automatable and a change applies the next time the host prepares.
+*/
+namespace ChorusQuality
+{
+    enum Mode
+    {
+        automatic = 0,
+        live,
+        render,
+        numModes
+    };
+
+    inline juce::StringArray getModeNames() { return { "Auto", "Live", "Render" }; }
+
+    //The tier a block runs at, Auto follows the host
+    inline int resolve(int mode, bool isNonRealtime) noexcept
+    {
+        if (mode == automatic)
+            return isNonRealtime ? render : live;
+
+        return mode;
+    }
+
+    //The interpolator the voices read with at the tier
+    inline int getInterpolation(int tier, int chosenInterpolation) noexcept
+    {
+        if (tier == render && chosenInterpolation != Interpolation::thiran)
+            return Interpolation::lagrange6;
+
+        return chosenInterpolation;
+    }
+}
+
+//==============================================================================
+/** One block's worth of parameter values, read once by the processor and handed to the engine. */
+struct ChorusParameters
+{
+    float dryWet = 0.5f;
+    float depth = 0.5f;
+    float rate = 10.f;
+    float phaseOffset = 0.f;
+    float feedback = 0.5f;
+    int type = ChorusType::chorus;
+    int waveform = ChorusLFO::sineWave;
+    int numVoices = 1;
+    int interpolation = Interpolation::linear;
+
+    //How long the output keeps ringing once the input stops: the longest delay, then one more trip round
+    //the loop for every time feedback has to scale the ring before it is below SILENCE_THRESHOLD
+    double getTailLengthSeconds() const
+    {
+        const double longestDelay = (type == ChorusType::flanger) ? FlangerKernel::maxDelay : ChorusKernel::maxDelay;
+        const double loopGain = juce::jlimit(0.0, 0.999, (double) std::abs(feedback));
+        const double roundTrips = (loopGain > 0) ? std::ceil(std::log((double) SILENCE_THRESHOLD) / std::log(loopGain)) : 0.0;
+        return longestDelay * (1.0 + roundTrips);
+    }
+};
+
+//==============================================================================
+/**
+    The chorus, templated on the sample type so the float and the double
+    processBlock run the same code.
+
+    Up to MAX_CHANNELS channels are processed in pairs, in sub-blocks no longer
+    than the shortest delay, with the delay loop at the base rate or 2 or 4
+    times it, in which case the output lags by getLatencyInSamples(). The
+    design notes in README.md cover the precision, ramps and idling.
+*/
+template <typename SampleType>
+class ChorusEngine
+{
+public:
+    using Frame = StereoFrame<SampleType>;
+    using DelayFrame = StereoFrame<double>; //the smoothed delay time, double in both engines
+
+    ChorusEngine()
+    {
+        mNumChannels = 0;
+        mNumLFOLanes = 0;
+        mIdleAfterSamples = 0;
+        mQuietSamples = 0;
+        mIdle = false;
+        mActiveType = ChorusType::chorus;
+        mFadingType = ChorusType::chorus;
+        mCrossfadeLength = 1;
+        mCrossfadeRemaining = 0;
+        mSampleRate = 0;
+        mLoopRate = 0;
+        mOversamplingFactor = 1;
+        mMaxOversamplingFactor = 1;
+
+       #if COOLCHORUS_SCOPE
+        mScopeFeed = nullptr;
+       #endif
+
+        for (int type = 0; type < ChorusType::numTypes; type++)
+            mDelaySmoothing[type] = 0;
+    }
+
+    //Sizes the delay lines for numChannels and clears all state, starting settled on initialParameters. The delay loop runs
+    //at oversamplingFactor (1, 2 or 4) times sampleRate, and is sized for up to maxOversamplingFactor so that
+    //setOversamplingFactor() can switch within that later. Allocates, so never call it from the audio thread
+    void prepare(double sampleRate, int numChannels, const ChorusParameters& initialParameters, int oversamplingFactor = 1, int maxOversamplingFactor = 1)
+    {
+        jassert(oversamplingFactor == 1 || oversamplingFactor == 2 || oversamplingFactor == 4);
+        jassert(maxOversamplingFactor == 1 || maxOversamplingFactor == 2 || maxOversamplingFactor == 4);
+
+        mSampleRate = sampleRate;
+        mMaxOversamplingFactor = juce::jmax(oversamplingFactor, maxOversamplingFactor);
+        mNumChannels = juce::jlimit(1, MAX_CHANNELS, numChannels);
+
+        //the buffers are sized for the fastest loop rate, the coefficients are set for the current one below
+        const double maxLoopRate = sampleRate * mMaxOversamplingFactor;
+
+        const int numPairs = (mNumChannels + 1) / 2;
+
+        while (mChannelPairs.size() > numPairs)
+            mChannelPairs.removeLast();
+
+        while (mChannelPairs.size() < numPairs)
+            mChannelPairs.add(new ChannelPair());
+
+        //Delay line long enough for the longest delay any Type reads, the two channels of a pair are interleaved in one buffer.
+        //The 3 covers the frames before x0 that the 6 point interpolator reads
+        for (auto* pair : mChannelPairs)
+        {
+            pair->delayLine.prepare((int) std::ceil(maxLoopRate * ChorusType::maxDelay) + 3, 2);
+
+            //the dry frames wait in a delay line of their own while the wet ones go through the filters
+            if (mMaxOversamplingFactor > 1)
+            {
+                const int maxLatency = juce::jmax(Oversampler<SampleType>::getLatencyInSamples(2), Oversampler<SampleType>::getLatencyInSamples(4));
+
+                pair->oversampler.prepare(mMaxOversamplingFactor, LFO_BLOCK_SIZE);
+                pair->dryDelay.prepare(maxLatency + LFO_BLOCK_SIZE, 2);
+            }
+        }
+
+        //One LFO row per lane of every pair, lane = (pair * numVoices + voice) * 2 + channel
+        const int maxLanes = numPairs * MAX_VOICES * 2;
+        mLFOBuffer.allocate((size_t) (maxLanes * LFO_BLOCK_SIZE), true);
+        mLFOOutputs.allocate((size_t) maxLanes, true);
+        mLanePhaseOffsets.allocate((size_t) maxLanes, true);
+        mNumLFOLanes = maxLanes;
+
+        for (int lane = 0; lane < maxLanes; lane++)
+            mLFOOutputs[lane] = mLFOBuffer + lane * LFO_BLOCK_SIZE;
+
+        juce::FloatVectorOperations::clear(mSpareChannel, LFO_BLOCK_SIZE);
+
+        setLoopRate(oversamplingFactor);
+        reset(initialParameters);
+    }
+
+    //Moves the delay loop to another factor of the prepared sample rate, no higher than the maxOversamplingFactor given to
+    //prepare(). Allocates nothing, so it can run on the audio thread between blocks, but it restarts the delay loop like
+    //reset() does, keeping only the LFO's place. The latency changes with it
+    void setOversamplingFactor(int oversamplingFactor, const ChorusParameters& parameters) noexcept
+    {
+        jassert(isPrepared());
+        jassert(oversamplingFactor <= mMaxOversamplingFactor);
+
+        if (oversamplingFactor == mOversamplingFactor || oversamplingFactor > mMaxOversamplingFactor)
+            return;
+
+        const float phase = mLFO.getPhase();
+
+        setLoopRate(oversamplingFactor);
+        reset(parameters);
+        mLFO.setPhase(phase);
+    }
+
+    int getOversamplingFactor() const noexcept { return mOversamplingFactor; }
+    int getMaxOversamplingFactor() const noexcept { return mMaxOversamplingFactor; }
+
+    //Clears the delay lines, the filters and the voice state and restarts the LFO, settled on parameters as prepare() leaves it.
+    //Keeps the allocation, so it is safe on the audio thread, e.g. for a transport jump
+    void reset(const ChorusParameters& parameters) noexcept
+    {
+        jassert(isPrepared());
+
+        mLFO.reset();
+
+        for (auto* pair : mChannelPairs)
+        {
+            pair->delayLine.reset();
+            pair->feedbackLeft = pair->feedbackRight = 0;
+
+            if (mMaxOversamplingFactor > 1)
+            {
+                pair->oversampler.reset();
+                pair->dryDelay.reset();
+            }
+        }
+
+        for (int type = 0; type < ChorusType::numTypes; type++)
+            resetKernelState(type);
+
+        mQuietSamples = 0;
+        mIdle = false;
+
+        mDryWetSmoothed.setCurrentAndTargetValue((SampleType) parameters.dryWet);
+        mFeedbackSmoothed.setCurrentAndTargetValue((SampleType) parameters.feedback);
+
+        //Start on the current Type without a crossfade
+        mActiveType = mFadingType = juce::jlimit(0, ChorusType::numTypes - 1, parameters.type);
+        mCrossfadeRemaining = 0;
+    }
+
+    bool isPrepared() const noexcept { return mNumChannels > 0; }
+
+    int getNumChannels() const noexcept { return mNumChannels; }
+
+    //True while the input is silent and the ring has died out, process() then only writes zeros
+    bool isIdle() const noexcept { return mIdle; }
+
+    //Where the LFO is in its cycle, 0 to 1, and a jump to another place in it, e.g. one saved with a session. The jump is
+    //heard as a jump, so make it where the wet signal is silent or the modulation starts over anyway
+    float getLFOPhase() const noexcept { return mLFO.getPhase(); }
+    void setLFOPhase(float phase) noexcept { mLFO.setPhase(phase); }
+
+    //Puts the LFO at a place in cycles from the start of the song, see ChorusLFO::sync
+    void syncLFO(double cycles, bool restart) noexcept { mLFO.sync(cycles, restart); }
+
+    //Samples the output lags the input by, the round trip through the oversampling filters
+    int getLatencyInSamples() const noexcept { return Oversampler<SampleType>::getLatencyInSamples(mOversamplingFactor); }
+
+   #if COOLCHORUS_SCOPE
+    //Receives a point of the modulation trace every sub-block while the feed is active, nullptr for none
+    void setScopeFeed(ScopeFeed* feed) noexcept { mScopeFeed = feed; }
+   #endif
+
+    //Heap memory held by the delay lines, the channel pairs and the LFO rows
+    size_t getAllocatedBytes() const noexcept
+    {
+        size_t bytes = (size_t) mNumLFOLanes * (LFO_BLOCK_SIZE * sizeof(float) + sizeof(float*) + sizeof(float));
+
+        for (auto* pair : mChannelPairs)
+        {
+            bytes += sizeof(ChannelPair) + pair->delayLine.getAllocatedBytes();
+
+            if (mMaxOversamplingFactor > 1)
+                bytes += pair->oversampler.getAllocatedBytes() + pair->dryDelay.getAllocatedBytes();
+        }
+
+        return bytes;
+    }
+
+    //channels holds the numChannels channels given to prepare(), each numSamples long, processed in place
+    void process(const ChorusParameters& parameters, SampleType* const* channels, int numChannels, int numSamples)
+    {
+        jassert(isPrepared());
+        jassert(numChannels == mNumChannels);
+        numChannels = juce::jmin(numChannels, mNumChannels);
+
+        //Idle: nothing is ringing and nothing came in, the parameters are taken as they are since there is nothing to smooth
+        const bool inputSilent = isSilent(channels, numChannels, numSamples);
+
+        if (mIdle && inputSilent) {
+            COOLCHORUS_TRACE_ZONE("Idle");
+
+            const int type = juce::jlimit(0, ChorusType::numTypes - 1, parameters.type);
+            if (type != mActiveType)
+                resetKernelState(type);
+
+            mActiveType = mFadingType = type;
+            mCrossfadeRemaining = 0;
+            mDryWetSmoothed.setCurrentAndTargetValue((SampleType) parameters.dryWet);
+            mFeedbackSmoothed.setCurrentAndTargetValue((SampleType) parameters.feedback);
+
+            //the modulation keeps its place, so coming back sounds as if the engine had run all along
+            mLFO.setWaveform(parameters.waveform);
+            mLFO.setFrequency(parameters.rate, (float) mSampleRate);
+            mLFO.advance(numSamples);
+
+            for ( int channel = 0; channel < numChannels; channel++ )
+                juce::FloatVectorOperations::clear(channels[channel], numSamples);
+
+            return;
+        }
+
+        mIdle = false;
+        SampleType writePeak = 0;
+
+        //Derived coefficients once per block, everything in the loop runs at the loop's rate
+        const int factor = mOversamplingFactor;
+        const float loopRate = (float) mLoopRate;
+        const SampleType depth = (SampleType) parameters.depth;
+        const float phaseOffset = parameters.phaseOffset;
+        const int interpolation = parameters.interpolation;
+
+        mLFO.setWaveform(parameters.waveform);
+        mLFO.setFrequency(parameters.rate, (float) mSampleRate);
+
+        //A new Type fades in over TYPE_CROSSFADE_TIME, changing back half way reverses the fade from where it is
+        const int type = juce::jlimit(0, ChorusType::numTypes - 1, parameters.type);
+        if (type != mActiveType) {
+            if (mCrossfadeRemaining > 0) {
+                mCrossfadeRemaining = mCrossfadeLength - mCrossfadeRemaining;
+            }
+            else {
+                resetKernelState(type);
+                mCrossfadeRemaining = mCrossfadeLength;
+            }
+
+            mFadingType = mActiveType;
+            mActiveType = type;
+        }
+
+        //Voices are spread evenly over the LFO cycle, channel c of every voice runs phaseOffset * c / (numChannels - 1) further along
+        const int numVoices = juce::jlimit(1, MAX_VOICES, parameters.numVoices);
+        const int numPairs = (numChannels + 1) / 2;
+        const int numLanes = numPairs * numVoices * 2;
+
+        for ( int pair = 0; pair < numPairs; pair++ ) {
+            for ( int voice = 0; voice < numVoices; voice++ ) {
+                const float voicePhase = (float) voice / (float) numVoices;
+
+                for ( int side = 0; side < 2; side++ ) {
+                    const int channel = pair * 2 + side;
+                    const float channelPhase = (numChannels > 1) ? phaseOffset * (float) channel / (float) (numChannels - 1) : 0.f;
+                    const float lanePhase = voicePhase + channelPhase;
+                    mLanePhaseOffsets[(pair * numVoices + voice) * 2 + side] = lanePhase - ((lanePhase >= 1.f) ? 1.f : 0.f);
+                }
+            }
+        }
+
+        mDryWetSmoothed.setTargetValue((SampleType) parameters.dryWet);
+        mFeedbackSmoothed.setTargetValue((SampleType) parameters.feedback);
+
+        //The gains the mix settles on, used as they are by every sub-block that is not ramping
+        const SampleType wet = mDryWetSmoothed.getTargetValue();
+        const SampleType voiceFeedback = mFeedbackSmoothed.getTargetValue() / (SampleType) numVoices;
+
+        //The two channels of a pair travel through the kernel as one StereoFrame, so every step below is a single vector op.
+        //The voices are summed, feedback uses their mean so the loop stays stable, the wet mix is scaled for equal power
+        MixGains gains;
+        gains.dry = Frame::expand((SampleType) 1 - wet);
+        gains.wet = Frame::expand(wet / std::sqrt((SampleType) numVoices));
+        gains.feedbackSign = getFeedbackSign(mActiveType);
+        gains.fadingFeedbackSign = getFeedbackSign(mFadingType);
+        gains.feedback = Frame::expand(voiceFeedback * gains.feedbackSign);
+        gains.fadingFeedback = Frame::expand(voiceFeedback * gains.fadingFeedbackSign);
+        gains.fadeStep = (SampleType) 1 / (SampleType) mCrossfadeLength;
+
+       #if COOLCHORUS_SCOPE
+        const bool scoping = mScopeFeed != nullptr && mScopeFeed->isActive();
+       #endif
+
+        //Every sub-block is shorter than the shortest delay of the kernels running, so all of its reads land on frames written by earlier sub-blocks
+        for ( int blockStart = 0; blockStart < numSamples; ) {
+
+            const bool crossfading = mCrossfadeRemaining > 0;
+            int blockSize = juce::jmin(getMaxSubBlockSize(mActiveType), numSamples - blockStart);
+
+            //a sub-block never runs past the end of the crossfade, so the faded out kernel stops exactly there
+            if (crossfading)
+                blockSize = juce::jmin(blockSize, getMaxSubBlockSize(mFadingType), mCrossfadeRemaining / factor);
+
+            //the sub-block in loop samples, the same as blockSize unless oversampling
+            const int loopSize = blockSize * factor;
+
+            //LFO: every lane of every pair comes from the same oscillator state. It always runs at the base rate, so the modulation is
+            //the same at every oversampling factor, and its values are held for the loop
+            mLFO.renderBlock(mLFOOutputs, mLanePhaseOffsets, numLanes, blockSize);
+
+            if (factor > 1)
+                holdLFOValues(numLanes, blockSize);
+
+            //Per sample gains, only while Dry Wet or Feedback is still on its way to the target
+            const bool ramping = mDryWetSmoothed.isSmoothing() || mFeedbackSmoothed.isSmoothing();
+            if (ramping)
+                renderRamps(numVoices, loopSize);
+
+            for ( int pairIndex = 0; pairIndex < numPairs; pairIndex++ ) {
+                ChannelPair& pair = *mChannelPairs.getUnchecked(pairIndex);
+                const float* const* lfoRows = mLFOOutputs + pairIndex * numVoices * 2;
+
+                SampleType* const left = channels[pairIndex * 2] + blockStart;
+                SampleType* const right = (pairIndex * 2 + 1 < numChannels) ? channels[pairIndex * 2 + 1] + blockStart : mSpareChannel;
+
+                //the spare lane is fed silence every sub-block, so its delay line and feedback stay at zero
+                if (right == mSpareChannel)
+                    juce::FloatVectorOperations::clear(mSpareChannel, blockSize);
+
+                //The loop's input, the pair's frames brought up to the loop's rate
+                const SampleType* loopInput = nullptr;
+                if (factor > 1)
+                    loopInput = upsamplePair(pair, left, right, blockSize);
+
+                //Delay trajectory and interpolated read for all voices, summed into the wet buffer
+                readKernel(pair, lfoRows, mActiveType, interpolation, numVoices, loopSize, depth, loopRate, mWetBuffer);
+
+                //Both kernels read the shared delay line while a change of Type fades
+                if (crossfading)
+                    readKernel(pair, lfoRows, mFadingType, interpolation, numVoices, loopSize, depth, loopRate, mFadingWetBuffer);
+
+                if (factor > 1)
+                {
+                    //the loop leaves its wet frames in mWetBuffer, they come down to the base rate and meet the dry ones there
+                    if (crossfading)
+                        ramping ? loopPair<true, true>(pair, loopInput, loopSize, gains) : loopPair<true, false>(pair, loopInput, loopSize, gains);
+                    else
+                        ramping ? loopPair<false, true>(pair, loopInput, loopSize, gains) : loopPair<false, false>(pair, loopInput, loopSize, gains);
+
+                    pair.delayLine.write(mWriteBuffer, loopSize);
+                    pair.oversampler.downsample(mWetBuffer, mDownsampledBuffer, blockSize);
+
+                    ramping ? mixOversampledPair<true>(pair, left, right, blockSize, gains) : mixOversampledPair<false>(pair, left, right, blockSize, gains);
+                }
+                else
+                {
+                    if (crossfading)
+                        ramping ? mixPair<true, true>(pair, left, right, blockSize, gains) : mixPair<true, false>(pair, left, right, blockSize, gains);
+                    else
+                        ramping ? mixPair<false, true>(pair, left, right, blockSize, gains) : mixPair<false, false>(pair, left, right, blockSize, gains);
+
+                    pair.delayLine.write(mWriteBuffer, blockSize);
+                }
+
+                //on silent input only the feedback is written, its level tells when the ring is over
+                if (inputSilent)
+                    writePeak = juce::jmax(writePeak, getPeak(mWriteBuffer, loopSize * 2));
+            }
+
+           #if COOLCHORUS_SCOPE
+            if (scoping)
+                pushScopePoint(loopSize);
+           #endif
+
+            if (crossfading)
+                mCrossfadeRemaining -= loopSize;
+
+            blockStart += blockSize;
+        }
+
+        if (inputSilent && writePeak < (SampleType) SILENCE_THRESHOLD)
+            mQuietSamples += numSamples * factor;
+        else
+            mQuietSamples = 0;
+
+        if (mQuietSamples >= mIdleAfterSamples)
+            enterIdle();
+    }
+
+private:
+    //==============================================================================
+    //Everything one pair of channels keeps between blocks, lane = voice * 2 + channel
+    struct ChannelPair
+    {
+        DelayLine<SampleType> delayLine; //interleaved left/right frames
+
+        //kept per Type so each kernel resumes where it was
+        alignas(16) double delayTimeSmoothed[ChorusType::numTypes][MAX_VOICES * 2];
+        alignas(16) SampleType interpolatorState[ChorusType::numTypes][MAX_VOICES * 2]; //last interpolated output, the Thiran allpass state
+
+        SampleType feedbackLeft = 0;
+        SampleType feedbackRight = 0;
+
+        //only prepared when oversampling
+        Oversampler<SampleType> oversampler;
+        DelayLine<SampleType> dryDelay; //interleaved input frames, read getLatencyInSamples() behind
+    };
+
+    //Constant gains of a block, the ramped ones come from the ramp buffers instead
+    struct MixGains
+    {
+        Frame dry, wet, feedback, fadingFeedback;
+        SampleType feedbackSign, fadingFeedbackSign;
+        SampleType fadeStep;
+    };
+
+    //Feedback and mix: the input plus the previous delayed sample goes into the delay line, the delayed signal is added to the dry signal
+    template <bool Crossfading, bool Ramping>
+    void mixPair(ChannelPair& pair, SampleType* left, SampleType* right, int blockSize, const MixGains& gains)
+    {
+        COOLCHORUS_TRACE_ZONE("Feedback and mix");
+
+        Frame feedbackState(pair.feedbackLeft, pair.feedbackRight);
+        Frame dryFrame = gains.dry;
+        Frame wetFrame = gains.wet;
+        Frame feedbackFrame = gains.feedback;
+        Frame fadingFeedbackFrame = gains.fadingFeedback;
+
+        for ( int n = 0; n < blockSize; n++ ) {
+            if constexpr (Ramping) {
+                dryFrame = Frame::expand(mDryRamp[n]);
+                wetFrame = Frame::expand(mWetRamp[n]);
+                feedbackFrame = Frame::expand(mFeedbackRamp[n] * gains.feedbackSign);
+                fadingFeedbackFrame = Frame::expand(mFeedbackRamp[n] * gains.fadingFeedbackSign);
+            }
+
+            const Frame input(left[n], right[n]);
+            const Frame activeSample = Frame::load(mWetBuffer + 2 * n);
+            Frame delaySample = activeSample;
+
+            (input + feedbackState).store(mWriteBuffer + 2 * n);
+
+            if constexpr (Crossfading) {
+                //the two kernels' outputs and feedback paths are crossfaded linearly so the loop gain never exceeds either kernel's.
+                //taken from the samples left rather than accumulated, so the ramp does not depend on how the host splits its blocks
+                const SampleType fadeIn = (SampleType) 1 - (SampleType) (mCrossfadeRemaining - n) * gains.fadeStep;
+                const Frame fadingSample = Frame::load(mFadingWetBuffer + 2 * n);
+                const Frame fadeInFrame = Frame::expand(fadeIn);
+                const Frame fadeOutFrame = Frame::expand((SampleType) 1 - fadeIn);
+
+                feedbackState = activeSample * fadeInFrame * feedbackFrame + fadingSample * fadeOutFrame * fadingFeedbackFrame;
+                delaySample = activeSample * fadeInFrame + fadingSample * fadeOutFrame;
+            }
+            else {
+                feedbackState = activeSample * feedbackFrame;
+            }
+
+            const Frame output = input * dryFrame + delaySample * wetFrame;
+            left[n] = output.getLeft();
+            right[n] = output.getRight();
+        }
+
+        //Store the state back for the next sub-block
+        pair.feedbackLeft = feedbackState.getLeft();
+        pair.feedbackRight = feedbackState.getRight();
+    }
+
+    //Stretches each lane's blockSize values to the loop's rate in place, every value repeated factor times. The steps are far
+    //shorter than the kernels' delay smoothing, which rounds them off
+    void holdLFOValues(int numLanes, int blockSize) noexcept
+    {
+        const int factor = mOversamplingFactor;
+
+        for ( int lane = 0; lane < numLanes; lane++ ) {
+            float* const row = mLFOOutputs[lane];
+
+            for ( int n = blockSize - 1; n >= 0; n-- )
+                for ( int k = factor - 1; k >= 0; k-- )
+                    row[n * factor + k] = row[n];
+        }
+    }
+
+    //Interleaves the pair's sub-block, keeps it for the dry mix and brings it up to the loop's rate
+    const SampleType* upsamplePair(ChannelPair& pair, const SampleType* left, const SampleType* right, int blockSize)
+    {
+        for ( int n = 0; n < blockSize; n++ )
+            Frame(left[n], right[n]).store(mInputBuffer + 2 * n);
+
+        pair.dryDelay.write(mInputBuffer, blockSize);
+        return pair.oversampler.upsample(mInputBuffer, blockSize);
+    }
+
+    //The feedback loop of mixPair() at the loop's rate, reading the upsampled input and leaving the wet frames in mWetBuffer
+    template <bool Crossfading, bool Ramping>
+    void loopPair(ChannelPair& pair, const SampleType* loopInput, int loopSize, const MixGains& gains)
+    {
+        COOLCHORUS_TRACE_ZONE("Feedback and mix");
+
+        Frame feedbackState(pair.feedbackLeft, pair.feedbackRight);
+        Frame feedbackFrame = gains.feedback;
+        Frame fadingFeedbackFrame = gains.fadingFeedback;
+
+        for ( int n = 0; n < loopSize; n++ ) {
+            if constexpr (Ramping) {
+                feedbackFrame = Frame::expand(mFeedbackRamp[n] * gains.feedbackSign);
+                fadingFeedbackFrame = Frame::expand(mFeedbackRamp[n] * gains.fadingFeedbackSign);
+            }
+
+            const Frame input = Frame::load(loopInput + 2 * n);
+            const Frame activeSample = Frame::load(mWetBuffer + 2 * n);
+
+            (input + feedbackState).store(mWriteBuffer + 2 * n);
+
+            if constexpr (Crossfading) {
+                const SampleType fadeIn = (SampleType) 1 - (SampleType) (mCrossfadeRemaining - n) * gains.fadeStep;
+                const Frame fadingSample = Frame::load(mFadingWetBuffer + 2 * n);
+                const Frame fadeInFrame = Frame::expand(fadeIn);
+                const Frame fadeOutFrame = Frame::expand((SampleType) 1 - fadeIn);
+
+                feedbackState = activeSample * fadeInFrame * feedbackFrame + fadingSample * fadeOutFrame * fadingFeedbackFrame;
+                (activeSample * fadeInFrame + fadingSample * fadeOutFrame).store(mWetBuffer + 2 * n);
+            }
+            else {
+                feedbackState = activeSample * feedbackFrame;
+            }
+        }
+
+        pair.feedbackLeft = feedbackState.getLeft();
+        pair.feedbackRight = feedbackState.getRight();
+    }
+
+    //The dry frames, held back by the filters' latency, and the downsampled wet frames mixed into the channels
+    template <bool Ramping>
+    void mixOversampledPair(const ChannelPair& pair, SampleType* left, SampleType* right, int blockSize, const MixGains& gains)
+    {
+        const SampleType* const dryBuffer = pair.dryDelay.getReadPointer();
+        const int dryMask = pair.dryDelay.getMask();
+        const int dryStart = pair.dryDelay.getWritePosition() - blockSize - getLatencyInSamples();
+
+        Frame dryFrame = gains.dry;
+        Frame wetFrame = gains.wet;
+
+        for ( int n = 0; n < blockSize; n++ ) {
+            //the ramps run at the loop's rate, every factor'th value lines up with a base sample
+            if constexpr (Ramping) {
+                dryFrame = Frame::expand(mDryRamp[n * mOversamplingFactor]);
+                wetFrame = Frame::expand(mWetRamp[n * mOversamplingFactor]);
+            }
+
+            const Frame dry = Frame::load(dryBuffer + 2 * ((dryStart + n) & dryMask));
+            const Frame output = dry * dryFrame + Frame::load(mDownsampledBuffer + 2 * n) * wetFrame;
+            left[n] = output.getLeft();
+            right[n] = output.getRight();
+        }
+    }
+
+    //Advances the smoothers by one sub-block, the same gains for every pair
+    void renderRamps(int numVoices, int blockSize)
+    {
+        COOLCHORUS_TRACE_ZONE("Ramps");
+
+        const SampleType wetScale = (SampleType) 1 / std::sqrt((SampleType) numVoices);
+        const SampleType feedbackScale = (SampleType) 1 / (SampleType) numVoices;
+
+        for ( int n = 0; n < blockSize; n++ ) {
+            const SampleType wet = mDryWetSmoothed.getNextValue();
+            mDryRamp[n] = (SampleType) 1 - wet;
+            mWetRamp[n] = wet * wetScale;
+            mFeedbackRamp[n] = mFeedbackSmoothed.getNextValue() * feedbackScale;
+        }
+    }
+
+    static SampleType getPeak(const SampleType* samples, int numSamples)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(samples, numSamples);
+        return juce::jmax(-range.getStart(), range.getEnd());
+    }
+
+    static bool isSilent(SampleType* const* channels, int numChannels, int numSamples)
+    {
+        COOLCHORUS_TRACE_ZONE("Silence check");
+
+        for ( int channel = 0; channel < numChannels; channel++ )
+            if (getPeak(channels[channel], numSamples) >= (SampleType) SILENCE_THRESHOLD)
+                return false;
+
+        return true;
+    }
+
+   #if COOLCHORUS_SCOPE
+    //Voice 1 of the first channel as it stands at the end of the sub-block, blockSize in loop samples
+    void pushScopePoint(int blockSize)
+    {
+        const ChannelPair& pair = *mChannelPairs.getUnchecked(0);
+        mScopeFeed->pushPoint({ mLFOOutputs[0][blockSize - 1],
+                                (float) pair.delayTimeSmoothed[mActiveType][0] * 1000.f,
+                                (float) blockSize / (float) mLoopRate });
+    }
+   #endif
+
+    //The rate dependent coefficients for the delay loop at factor times the sample rate, allocates nothing
+    void setLoopRate(int factor) noexcept
+    {
+        mOversamplingFactor = factor;
+        mLoopRate = mSampleRate * factor;
+
+        if (factor > 1)
+            for (auto* pair : mChannelPairs)
+                pair->oversampler.setFactor(factor);
+
+        //Once every frame in the delay line is below the threshold the ring is over
+        mIdleAfterSamples = (int) std::ceil(mLoopRate * ChorusType::maxDelay) + 3;
+
+        //The one pole coefficients for the kernels' smoothing times at this rate
+        mDelaySmoothing[ChorusKernel::type] = getSmoothingCoefficient(ChorusKernel::smoothingTime, mLoopRate);
+        mDelaySmoothing[FlangerKernel::type] = getSmoothingCoefficient(FlangerKernel::smoothingTime, mLoopRate);
+
+        mDryWetSmoothed.reset(mLoopRate, PARAMETER_RAMP_TIME);
+        mFeedbackSmoothed.reset(mLoopRate, PARAMETER_RAMP_TIME);
+
+        //in loop samples, a whole number of base samples so every crossfade ends on a sub-block boundary
+        mCrossfadeLength = factor * juce::jmax(1, (int) (mSampleRate * TYPE_CROSSFADE_TIME));
+    }
+
+    //Clears what is left of the ring, so the block that ends the silence starts from nothing
+    void enterIdle()
+    {
+        for (auto* pair : mChannelPairs)
+        {
+            pair->delayLine.reset();
+            pair->feedbackLeft = pair->feedbackRight = 0;
+
+            if (mMaxOversamplingFactor > 1)
+            {
+                pair->oversampler.reset();
+                pair->dryDelay.reset();
+            }
+
+            for (int type = 0; type < ChorusType::numTypes; type++)
+                for (int lane = 0; lane < MAX_VOICES * 2; lane++)
+                    pair->interpolatorState[type][lane] = 0;
+        }
+
+        mQuietSamples = 0;
+        mIdle = true;
+    }
+
+    //One pole coefficient that closes 1 - 1/e of the gap in smoothingTime seconds
+    static double getSmoothingCoefficient(float smoothingTime, double sampleRate)
+    {
+        return 1.0 - std::exp(-1.0 / (smoothingTime * sampleRate));
+    }
+
+    static SampleType getFeedbackSign(int type) noexcept
+    {
+        return (SampleType) ((type == ChorusType::flanger) ? FlangerKernel::feedbackSign : ChorusKernel::feedbackSign);
+    }
+
+    //Starts the smoothed delay at the centre of the kernel's sweep rather than at zero
+    void resetKernelState(int type)
+    {
+        const float centreDelay = (type == ChorusType::flanger) ? FlangerKernel::centreDelay : ChorusKernel::centreDelay;
+
+        for (auto* pair : mChannelPairs)
+        {
+            for (int lane = 0; lane < MAX_VOICES * 2; lane++)
+            {
+                pair->delayTimeSmoothed[type][lane] = (double) centreDelay;
+                pair->interpolatorState[type][lane] = 0;
+            }
+        }
+    }
+
+    //Every sub-block has to be shorter than the kernel's shortest delay. The 6 point interpolator reads two frames past x1
+    //and the smoothed delay can round to just under minDelay, hence the - 3. In base samples, its loop samples have to fit the buffers
+    int getMaxSubBlockSize(int type) const
+    {
+        const float minDelay = (type == ChorusType::flanger) ? FlangerKernel::minDelay : ChorusKernel::minDelay;
+        return juce::jlimit(1, LFO_BLOCK_SIZE / mOversamplingFactor, ((int) (mLoopRate * minDelay) - 3) / mOversamplingFactor);
+    }
+
+    //Picks the compiled kernel for the Type, interpolator and voice count, called once per sub-block for each running kernel
+    void readKernel(ChannelPair& pair, const float* const* lfoRows, int type, int interpolation, int numVoices, int blockSize, SampleType depth, float sampleRate, SampleType* wetBuffer)
+    {
+        //the delay trajectory and the interpolated read are one loop, so they are one zone
+        COOLCHORUS_TRACE_ZONE("Delay read and interpolation");
+
+        if (type == ChorusType::flanger)
+        {
+            switch (interpolation)
+            {
+                case Interpolation::hermite:   readVoices<FlangerKernel, HermiteInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                case Interpolation::lagrange:  readVoices<FlangerKernel, LagrangeInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                case Interpolation::thiran:    readVoices<FlangerKernel, ThiranInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                case Interpolation::lagrange6: readVoices<FlangerKernel, Lagrange6Interpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                default:                       readVoices<FlangerKernel, LinearInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+            }
+        }
+        else
+        {
+            switch (interpolation)
+            {
+                case Interpolation::hermite:   readVoices<ChorusKernel, HermiteInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                case Interpolation::lagrange:  readVoices<ChorusKernel, LagrangeInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                case Interpolation::thiran:    readVoices<ChorusKernel, ThiranInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                case Interpolation::lagrange6: readVoices<ChorusKernel, Lagrange6Interpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+                default:                       readVoices<ChorusKernel, LinearInterpolator>(pair, lfoRows, numVoices, blockSize, depth, sampleRate, wetBuffer); break;
+            }
+        }
+    }
+
+    template <typename Kernel, typename Interpolator>
+    void readVoices(ChannelPair& pair, const float* const* lfoRows, int numVoices, int blockSize, SampleType depth, float sampleRate, SampleType* wetBuffer)
+    {
+        switch (numVoices)
+        {
+            case 1: readVoices<Kernel, Interpolator, 1>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            case 2: readVoices<Kernel, Interpolator, 2>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            case 3: readVoices<Kernel, Interpolator, 3>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            case 4: readVoices<Kernel, Interpolator, 4>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            case 5: readVoices<Kernel, Interpolator, 5>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            case 6: readVoices<Kernel, Interpolator, 6>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            case 7: readVoices<Kernel, Interpolator, 7>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+            default: readVoices<Kernel, Interpolator, 8>(pair, lfoRows, blockSize, depth, sampleRate, wetBuffer); break;
+        }
+    }
+
+    //Type, voice count and interpolator are template parameters so the voice loop unrolls and each voice's state stays in registers.
+    //Voices are the inner loop, which lets their smoothing recursions overlap instead of running one after the other.
+    template <typename Kernel, typename Interpolator, int NumVoices>
+    void readVoices(ChannelPair& pair, const float* const* lfoRows, int blockSize, SampleType depth, float sampleRate, SampleType* wetBuffer)
+    {
+        //jmap(lfoOut, -1, 1, minDelay, maxDelay) folded into a centre and a half range, depth pre-multiplied.
+        //The delay time and its read position are double, only the fraction handed to the interpolator is SampleType.
+        const DelayFrame delayCentreFrame = DelayFrame::expand((double) Kernel::centreDelay);
+        const DelayFrame delaySwingFrame = DelayFrame::expand(0.5 * ((double) Kernel::maxDelay - (double) Kernel::minDelay) * (double) depth);
+        const DelayFrame smoothingFrame = DelayFrame::expand(mDelaySmoothing[Kernel::type]);
+        const DelayFrame sampleRateFrame = DelayFrame::expand((double) sampleRate);
+        const Frame oneFrame = Frame::expand((SampleType) 1);
+
+        const SampleType* const delayBuffer = pair.delayLine.getReadPointer();
+        const int delayMask = pair.delayLine.getMask();
+        const int writePosition = pair.delayLine.getWritePosition();
+
+        double* const delayTimeState = pair.delayTimeSmoothed[Kernel::type];
+        SampleType* const interpolatorStateStore = pair.interpolatorState[Kernel::type];
+
+        DelayFrame delayTimeSmoothed[NumVoices];
+        Frame interpolatorState[NumVoices];
+        for ( int voice = 0; voice < NumVoices; voice++ ) {
+            delayTimeSmoothed[voice] = DelayFrame::load(delayTimeState + voice * 2);
+            interpolatorState[voice] = Frame::load(interpolatorStateStore + voice * 2);
+        }
+
+        for ( int n = 0; n < blockSize; n++ ) {
+
+            Frame wetSum = Frame::expand((SampleType) 0);
+
+            for ( int voice = 0; voice < NumVoices; voice++ ) {
+                const DelayFrame lfoOut((double) lfoRows[voice * 2][n], (double) lfoRows[voice * 2 + 1][n]);
+                const DelayFrame lfoOutMapped = delayCentreFrame + lfoOut * delaySwingFrame;
+
+                delayTimeSmoothed[voice] = delayTimeSmoothed[voice] - smoothingFrame * (delayTimeSmoothed[voice] - lfoOutMapped);
+
+                //position = writePosition + n - delay with the integer part kept out of the float
+                int delayLeft, delayRight;
+                const DelayFrame delayFraction = DelayFrame::splitIndex(delayTimeSmoothed[voice] * sampleRateFrame, delayLeft, delayRight);
+                const Frame readHeadFloat = oneFrame - convertFrame<SampleType>(delayFraction); //the difference between the two readheads
+
+                //frame x0 is at writePosition + n - delay - 1, the interpolator's points start pointsBefore frames earlier
+                const int readHeadLeft_x = (writePosition + n - delayLeft - 1 - Interpolator::pointsBefore) & delayMask;
+                const int readHeadRight_x = (writePosition + n - delayRight - 1 - Interpolator::pointsBefore) & delayMask;
+
+                //two points per gather, the count is a constant so the loop unrolls
+                Frame samples[Interpolator::numPoints];
+                for ( int point = 0; point < Interpolator::numPoints; point += 2 )
+                    Frame::gatherInterleaved(delayBuffer, readHeadLeft_x + point, readHeadRight_x + point, samples[point], samples[point + 1]);
+
+                interpolatorState[voice] = Interpolator::process(samples, readHeadFloat, interpolatorState[voice]);
+                wetSum = wetSum + interpolatorState[voice];
+            }
+
+            wetSum.store(wetBuffer + 2 * n);
+        }
+
+        for ( int voice = 0; voice < NumVoices; voice++ ) {
+            delayTimeSmoothed[voice].store(delayTimeState + voice * 2);
+            interpolatorState[voice].store(interpolatorStateStore + voice * 2);
+        }
+    }
+
+    //==============================================================================
+    ChorusLFO mLFO;
+
+    //Allocated by prepare() for the channel count, one row and phase offset per lane of every pair
+    juce::OwnedArray<ChannelPair> mChannelPairs;
+    juce::HeapBlock<float> mLFOBuffer;
+    juce::HeapBlock<float*> mLFOOutputs; //points at the rows of mLFOBuffer
+    juce::HeapBlock<float> mLanePhaseOffsets;
+    int mNumLFOLanes;
+    int mNumChannels;
+
+    //Dry Wet and Feedback, ramped per sample by renderRamps() only while they move
+    juce::SmoothedValue<SampleType> mDryWetSmoothed;
+    juce::SmoothedValue<SampleType> mFeedbackSmoothed;
+    alignas(16) SampleType mDryRamp[LFO_BLOCK_SIZE];
+    alignas(16) SampleType mWetRamp[LFO_BLOCK_SIZE]; //already scaled for the voice count
+    alignas(16) SampleType mFeedbackRamp[LFO_BLOCK_SIZE]; //per voice, without the Type's sign
+    double mDelaySmoothing[ChorusType::numTypes]; //one pole coefficient of each kernel at the current rate
+
+    //Silence detection, mQuietSamples counts the samples since the input or the feedback was last above the threshold
+    int mIdleAfterSamples;
+    int mQuietSamples;
+    bool mIdle;
+
+    //Per sub-block scratch, interleaved left/right frames, in loop samples. Aligned like the delay line so frame loads never straddle
+    alignas(16) SampleType mWetBuffer[LFO_BLOCK_SIZE * 2];
+    alignas(16) SampleType mFadingWetBuffer[LFO_BLOCK_SIZE * 2]; //output of the kernel being faded out
+    alignas(16) SampleType mWriteBuffer[LFO_BLOCK_SIZE * 2];
+    alignas(16) SampleType mSpareChannel[LFO_BLOCK_SIZE]; //the silent partner of an odd channel out
+
+    //Oversampling scratch at the base rate, the pair's input frames and its wet frames come back down
+    alignas(16) SampleType mInputBuffer[LFO_BLOCK_SIZE * 2];
+    alignas(16) SampleType mDownsampledBuffer[LFO_BLOCK_SIZE * 2];
+
+    //Type crossfade, the faded out kernel only runs while mCrossfadeRemaining > 0
+    int mActiveType;
+    int mFadingType;
+    int mCrossfadeLength;
+    int mCrossfadeRemaining;
+
+    double mSampleRate;
+    double mLoopRate; //mSampleRate times mOversamplingFactor
+    int mOversamplingFactor;
+    int mMaxOversamplingFactor; //what the buffers were prepared for
+
+   #if COOLCHORUS_SCOPE
+    ScopeFeed* mScopeFeed;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChorusEngine)
+};
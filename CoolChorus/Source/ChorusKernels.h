@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    ChorusKernels.h
+
+    Compile time settings for the kernels behind the Type parameter.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace ChorusType
+{
+    enum Type
+    {
+        chorus = 0,
+        flanger,
+        numTypes
+    };
+}
+
+//==============================================================================
+/**
+    The constants of a Type, which the voice kernel is specialised on: the
+    delay range in seconds and the centre it starts at, the time constant of
+    the one pole smoothing its delay and the polarity of its feedback.
+    minDelay also bounds the sub-block length.
+*/
+struct ChorusKernel
+{
+    static constexpr int type = ChorusType::chorus;
+
+    static constexpr float minDelay = 0.005f;
+    static constexpr float maxDelay = 0.03f;
+    static constexpr float centreDelay = 0.5f * (minDelay + maxDelay);
+
+    //smoothing helps when lfo is using a saw tooth or other types of waveforms to prevents clicks.
+    //About 0.001 per sample at 44.1 kHz (Previously 0.0001)
+    static constexpr float smoothingTime = 0.0227f;
+    static constexpr float feedbackSign = 1.f;
+};
+
+/**
+    Short delays for comb filtering that sweeps through the spectrum. The
+    smoothing is faster so the shallower sweep is not flattened, and the feedback
+    is inverted, which moves the comb's peaks to odd multiples of half its
+    fundamental for the hollow sound of a negative flanger.
+*/
+struct FlangerKernel
+{
+    static constexpr int type = ChorusType::flanger;
+
+    static constexpr float minDelay = 0.001f;
+    static constexpr float maxDelay = 0.007f;
+    static constexpr float centreDelay = 0.5f * (minDelay + maxDelay);
+
+    static constexpr float smoothingTime = 0.0045f; //about 0.005 per sample at 44.1 kHz
+    static constexpr float feedbackSign = -1.f;
+};
+
+namespace ChorusType
+{
+    //Longest delay any Type reads. The delay line is sized for it, so a change of Type never reallocates
+    constexpr float maxDelay = juce::jmax(ChorusKernel::maxDelay, FlangerKernel::maxDelay);
+}
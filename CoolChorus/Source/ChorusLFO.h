@@ -0,0 +1,351 @@
+/*
+  ==============================================================================
+
+    ChorusLFO.h
+
+    Block based LFO used to modulate the chorus delay time.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TraceZones.h"
+
+//==============================================================================
+/**
+    Renders a block of modulation values in [-1, 1] for any number of
+    trajectories at fixed phase offsets from one oscillator.
+
+    Sine and saw are read from shared 2048 point tables, within maxSineError,
+    the triangle is computed from the phase and the random shape glides from
+    one target to the next once per cycle. The phase is accumulated in double.
+*/
+class ChorusLFO
+{
+public:
+    enum Waveform
+    {
+        sineWave = 0,
+        triangleWave,
+        sawWave,
+        randomWave,
+        numWaveforms
+    };
+
+    ChorusLFO()
+    {
+        //Builds the shared tables here, so it never happens on the audio thread
+        getTables();
+        reset();
+    }
+
+    void reset(float startPhase = 0.f)
+    {
+        mPhase = startPhase;
+        mRandomIndex = 1;
+        mRandomTargets[0] = 0.f;
+        mRandomTargets[1] = nextRandom();
+        mRandomTargets[2] = nextRandom();
+    }
+
+    void setWaveform(int newWaveform)
+    {
+        jassert(newWaveform >= 0 && newWaveform < numWaveforms);
+        mWaveform = newWaveform;
+    }
+
+    void setFrequency(float frequency, float sampleRate)
+    {
+        mPhaseIncrement = (double) frequency / (double) sampleRate; //frequency/sr
+        jassert(mPhaseIncrement < 1.0);
+    }
+
+    float getPhase() const { return (float) mPhase; }
+
+    //Moves the oscillator to phase (in cycles) without restarting the random shape
+    void setPhase(float phase)
+    {
+        const double wrapped = (double) phase - std::floor((double) phase);
+        mPhase = wrapped < 1.0 ? wrapped : 0.0;
+    }
+
+    //Moves the oscillator to a place given in cycles from a fixed point, e.g. the start of the song. With restart the random
+    //shape also starts over, on targets drawn from the number of whole cycles, so it is the same there however it was reached
+    void sync(double cycles, bool restart)
+    {
+        const double wholeCycles = std::floor(cycles);
+        double phase = cycles - wholeCycles;
+
+        //A correction between jumps is a tiny one, it stays on the oscillator's side of a wrap so the random shape moves
+        //on to its next target once per cycle, not twice or never
+        if (! restart)
+        {
+            if (mPhase > 0.5 && phase < mPhase - 0.5)
+                phase = std::nextafter(1.0, 0.0);
+            else if (mPhase < 0.5 && phase > mPhase + 0.5)
+                phase = 0.0;
+        }
+
+        mPhase = phase < 1.0 ? phase : 0.0;
+
+        if (restart)
+        {
+            mRandomIndex = (juce::uint32) (juce::int64) wholeCycles;
+            mRandomTargets[0] = nextRandom();
+            mRandomTargets[1] = nextRandom();
+            mRandomTargets[2] = nextRandom();
+        }
+    }
+
+    int getWaveform() const { return mWaveform; }
+
+    //Fills output with numSamples LFO values and advances the phase
+    void renderBlock(float* output, int numSamples)
+    {
+        const float noOffset = 0.f;
+        renderBlock(&output, &noOffset, 1, numSamples);
+    }
+
+    //Fills outputs[k] with the trajectory running phaseOffsets[k] (in cycles, 0 to 1) ahead of the oscillator
+    void renderBlock(float* const* outputs, const float* phaseOffsets, int numOutputs, int numSamples)
+    {
+        COOLCHORUS_TRACE_ZONE("LFO");
+
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            const int blockSize = juce::jmin(maxBlockSize, numSamples - start);
+
+            switch (mWaveform)
+            {
+                case triangleWave:  renderWaveform<triangleWave>(outputs, phaseOffsets, numOutputs, start, blockSize); break;
+                case sawWave:       renderWaveform<sawWave>(outputs, phaseOffsets, numOutputs, start, blockSize); break;
+                case randomWave:    renderWaveform<randomWave>(outputs, phaseOffsets, numOutputs, start, blockSize); break;
+                default:            renderWaveform<sineWave>(outputs, phaseOffsets, numOutputs, start, blockSize); break;
+            }
+        }
+    }
+
+    //Moves the oscillator on by numSamples without rendering anything, for blocks whose modulation is not heard
+    void advance(int numSamples)
+    {
+        const double phase = mPhase + mPhaseIncrement * numSamples;
+        const int numWraps = (int) phase;
+        mPhase = phase - numWraps;
+
+        //the random shape draws the same targets it would have while rendering
+        if (mWaveform == randomWave)
+        {
+            for (int i = 0; i < numWraps; ++i)
+            {
+                mRandomTargets[0] = mRandomTargets[1];
+                mRandomTargets[1] = mRandomTargets[2];
+                mRandomTargets[2] = nextRandom();
+            }
+        }
+    }
+
+    static juce::StringArray getWaveformNames() { return { "Sine", "Triangle", "Saw", "Random" }; }
+
+    //Worst case error of a sine trajectory against sin() in double: a linearly interpolated 2048 point table is off by
+    //at most (2pi / 2048)^2 / 8, about 1.2e-6, and a trajectory sums two reads
+    static constexpr double maxSineError = 2.5e-6;
+
+private:
+    //==============================================================================
+    static constexpr int tableSize = 2048;
+    static constexpr int maxBlockSize = 256;
+
+    struct Tables
+    {
+        Tables()
+        {
+            //one guard point at the end so the interpolated read never wraps
+            for (int i = 0; i <= tableSize; ++i)
+                sine[i] = (float) std::sin(juce::MathConstants<double>::twoPi * i / tableSize);
+
+            //saw built from its first harmonics with Lanczos smoothing, so the reset is rounded instead of a click
+            const int numHarmonics = 8;
+            float peak = 0.f;
+
+            for (int i = 0; i <= tableSize; ++i)
+            {
+                double value = 0.0;
+
+                for (int k = 1; k <= numHarmonics; ++k)
+                {
+                    const double sigmaArg = juce::MathConstants<double>::pi * k / (numHarmonics + 1);
+                    const double sigma = std::sin(sigmaArg) / sigmaArg;
+                    value -= sigma * std::sin(juce::MathConstants<double>::twoPi * k * i / tableSize) / k;
+                }
+
+                saw[i] = (float) value;
+                peak = juce::jmax(peak, std::abs(saw[i]));
+            }
+
+            for (auto& value : saw)
+                value /= peak;
+        }
+
+        float sine[tableSize + 1];
+        float saw[tableSize + 1];
+    };
+
+    static const Tables& getTables()
+    {
+        static const Tables tables;
+        return tables;
+    }
+
+    static float lookup(const float* table, float phase) noexcept
+    {
+        const float position = phase * tableSize;
+        const int index = (int) position;
+        const float fraction = position - index;
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    float nextRandom() noexcept
+    {
+        //The target of cycle k is a hash of k, cheap and deterministic so renders are repeatable, and a synced LFO finds
+        //the targets of any place in the song without drawing the ones before it
+        juce::uint32 x = mRandomIndex++ * 0x9e3779b9u + 0x2545f491u;
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return (float) (x >> 8) * (2.f / 16777216.f) - 1.f;
+    }
+
+    template <int waveform>
+    float valueAt(const Tables& tables, float phase, float randomFrom, float randomTo) const noexcept
+    {
+        if constexpr (waveform == sineWave)
+        {
+            return lookup(tables.sine, phase);
+        }
+        else if constexpr (waveform == triangleWave)
+        {
+            //shifted by a quarter cycle so it starts at zero and rises, like the sine
+            float shifted = phase + 0.25f;
+            shifted -= (shifted >= 1.f) ? 1.f : 0.f;
+            return 1.f - 4.f * std::abs(shifted - 0.5f);
+        }
+        else if constexpr (waveform == sawWave)
+        {
+            return lookup(tables.saw, phase);
+        }
+        else
+        {
+            //cos(pi * phase) read from the sine table, gives a raised cosine glide between targets
+            const float glide = 0.5f - 0.5f * lookup(tables.sine, 0.5f * phase + 0.25f);
+            return randomFrom + glide * (randomTo - randomFrom);
+        }
+    }
+
+    template <int waveform>
+    void renderWaveform(float* const* outputs, const float* phaseOffsets, int numOutputs, int start, int numSamples) noexcept
+    {
+        const Tables& tables = getTables();
+        const double increment = mPhaseIncrement;
+        double phase = mPhase;
+        int numSegments = 0;
+
+        //Oscillator phase for the block. For the random shape, which target segment every sample sits in,
+        //with mRandomTargets holding the from/to/next targets plus one more for each wrap in the block
+        for (int i = 0; i < numSamples; ++i)
+        {
+            //a phase just below 1 rounds to 1 in float, which would read past the tables
+            mPhaseBuffer[i] = juce::jmin((float) phase, 0.99999994f);
+            phase += increment;
+
+            if constexpr (waveform == randomWave)
+                mSegmentBuffer[i] = numSegments;
+
+            if (phase >= 1.0)
+            {
+                phase -= 1.0;
+
+                if constexpr (waveform == randomWave)
+                    mRandomTargets[2 + ++numSegments] = nextRandom();
+            }
+        }
+
+        mPhase = phase;
+
+        if constexpr (waveform == sineWave)
+        {
+            for (int i = 0; i < numSamples; ++i)
+            {
+                float quadrature = mPhaseBuffer[i] + 0.25f;
+                quadrature -= (quadrature >= 1.f) ? 1.f : 0.f;
+
+                mSineBuffer[i] = lookup(tables.sine, mPhaseBuffer[i]);
+                mCosineBuffer[i] = lookup(tables.sine, quadrature);
+            }
+
+            for (int k = 0; k < numOutputs; ++k)
+            {
+                float* const output = outputs[k] + start;
+                const float phaseOffset = phaseOffsets[k] - ((phaseOffsets[k] >= 1.f) ? 1.f : 0.f);
+                const float quadratureOffset = phaseOffset + ((phaseOffset < 0.75f) ? 0.25f : -0.75f);
+                const float sineOffset = lookup(tables.sine, phaseOffset);
+                const float cosineOffset = lookup(tables.sine, quadratureOffset);
+
+                for (int i = 0; i < numSamples; ++i)
+                    output[i] = mSineBuffer[i] * cosineOffset + mCosineBuffer[i] * sineOffset;
+            }
+
+            return;
+        }
+
+        for (int k = 0; k < numOutputs; ++k)
+        {
+            float* const output = outputs[k] + start;
+            const float phaseOffset = phaseOffsets[k] - ((phaseOffsets[k] >= 1.f) ? 1.f : 0.f);
+            jassert(phaseOffset >= 0.f && phaseOffset < 1.f);
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                //a shifted phase that has wrapped is already one segment further along
+                float shifted = mPhaseBuffer[i] + phaseOffset;
+                const int wrapped = (shifted >= 1.f) ? 1 : 0;
+                shifted -= (float) wrapped;
+
+                if constexpr (waveform == randomWave)
+                {
+                    const int segment = mSegmentBuffer[i] + wrapped;
+                    output[i] = valueAt<waveform>(tables, shifted, mRandomTargets[segment], mRandomTargets[segment + 1]);
+                }
+                else
+                {
+                    output[i] = valueAt<waveform>(tables, shifted, 0.f, 0.f);
+                }
+            }
+        }
+
+        //the last three targets carry over as from/to/next for the next block
+        if constexpr (waveform == randomWave)
+        {
+            for (int i = 0; i < 3; ++i)
+                mRandomTargets[i] = mRandomTargets[numSegments + i];
+        }
+    }
+
+    //==============================================================================
+    double mPhase = 0.0;
+    double mPhaseIncrement = 0.0;
+    int mWaveform = sineWave;
+
+    juce::uint32 mRandomIndex = 0;  //the cycle whose target nextRandom() draws
+    float mRandomTargets[maxBlockSize + 3] = {};
+
+    float mPhaseBuffer[maxBlockSize];
+    float mSineBuffer[maxBlockSize];
+    float mCosineBuffer[maxBlockSize];
+    int mSegmentBuffer[maxBlockSize];
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChorusLFO)
+};
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    ChorusProcessor.h
+
+    The chorus as a juce::dsp processor, for use outside the plugin.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusEngine.h"
+
+//==============================================================================
+/**
+    A ChorusEngine behind the juce::dsp processor interface.
+
+    process() runs in place on the output block, a context with separate
+    blocks has the input copied over first, and the block must not have more
+    channels than prepare() was given. Set the parameters from the thread that
+    calls process(): setParameters() ramps to them, recall() fades the wet
+    signal out and back in on them, for a preset. A new oversampling factor
+    takes effect at the next process() if prepare() allocated for it, at the
+    next prepare() if not. Hold it on the heap, its buffers are several
+    kilobytes.
+
+    @code
+    juce::dsp::ProcessorChain<juce::dsp::Gain<float>, ChorusProcessor<float>> chain;
+    chain.get<1>().setParameters (parameters);
+    chain.prepare ({ sampleRate, (juce::uint32) blockSize, 2 });
+    chain.process (juce::dsp::ProcessContextReplacing<float> (block));
+    @endcode
+*/
+template <typename SampleType>
+class ChorusProcessor
+{
+public:
+    ChorusProcessor() = default;
+
+    //==============================================================================
+    //Allocates for spec.numChannels at spec.sampleRate and clears all state, so never call it from the audio thread.
+    //The block size is not needed, the engine works through any block in sub-blocks of its own
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0 && spec.numChannels > 0);
+        mEngine.prepare (spec.sampleRate, (int) spec.numChannels, mParameters, mOversamplingFactor, mMaxOversamplingFactor);
+
+        //the engine's Dry Wet ramp in samples at the base rate, a recall's fade out lasts no shorter
+        mRecallLength = juce::jmax (1, (int) std::ceil (spec.sampleRate * PARAMETER_RAMP_TIME));
+        mRecallRemaining = 0;
+    }
+
+    //Clears the delay lines and restarts the LFO without allocating
+    void reset() noexcept
+    {
+        if (mEngine.isPrepared())
+            mEngine.reset (mParameters);
+
+        mRecallRemaining = 0;
+    }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        static_assert (std::is_same<typename ProcessContext::SampleType, SampleType>::value,
+                       "The context has to be of the processor's sample type");
+
+        auto&& inputBlock = context.getInputBlock();
+        auto&& outputBlock = context.getOutputBlock();
+        const int numChannels = (int) outputBlock.getNumChannels();
+        const int numSamples = (int) outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == outputBlock.getNumSamples());
+
+        if (context.usesSeparateInputAndOutputBlocks())
+            outputBlock.copyFrom (inputBlock);
+
+        if (context.isBypassed || numSamples == 0)
+            return;
+
+        jassert (mEngine.isPrepared() && numChannels <= mEngine.getNumChannels());
+
+        SampleType* channels[MAX_CHANNELS];
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = outputBlock.getChannelPointer ((size_t) channel);
+
+        const int numEngineChannels = juce::jmin (numChannels, mEngine.getNumChannels());
+
+        //A factor change restarts the delay loop, so whatever a recall was fading out is gone with it
+        if (mOversamplingFactor != mEngine.getOversamplingFactor() && mOversamplingFactor <= mEngine.getMaxOversamplingFactor())
+        {
+            mEngine.setOversamplingFactor (mOversamplingFactor, mParameters);
+            mRecallRemaining = 0;
+        }
+
+        //The part of a recall's fade out that falls in this block still runs on the old parameters, the rest on the new ones
+        if (mRecallRemaining > 0)
+        {
+            const int fadeSamples = juce::jmin (mRecallRemaining, numSamples);
+            mEngine.process (mRecallFrom, channels, numEngineChannels, fadeSamples);
+            mRecallRemaining -= fadeSamples;
+
+            if (fadeSamples == numSamples)
+                return;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                channels[channel] += fadeSamples;
+
+            mEngine.process (mParameters, channels, numEngineChannels, numSamples - fadeSamples);
+            return;
+        }
+
+        mEngine.process (mParameters, channels, numEngineChannels, numSamples);
+    }
+
+    //==============================================================================
+    void setParameters (const ChorusParameters& newParameters) noexcept     { mParameters = newParameters; }
+    const ChorusParameters& getParameters() const noexcept                  { return mParameters; }
+
+    //Moves to newParameters through a dip of the wet signal rather than smoothing, for a preset change. Allocates nothing,
+    //so a preset can be recalled from the audio thread. A recall during another one's fade out keeps fading out
+    void recall (const ChorusParameters& newParameters) noexcept
+    {
+        if (mRecallRemaining == 0)
+        {
+            mRecallFrom = mParameters;
+            mRecallFrom.dryWet = 0;
+            mRecallRemaining = mRecallLength;
+        }
+
+        mParameters = newParameters;
+    }
+
+    //Where the LFO is in its cycle, 0 to 1, and a jump to another place in it, e.g. one saved with a session
+    float getLFOPhase() const noexcept              { return mEngine.getLFOPhase(); }
+    void setLFOPhase (float phase) noexcept         { mEngine.setLFOPhase (phase); }
+
+    //Puts the LFO at the song position in LFO cycles, once per block for a tempo synced LFO. With restart after a
+    //transport jump the random shape also starts over from there
+    void syncLFO (double cycles, bool restart) noexcept     { mEngine.syncLFO (cycles, restart); }
+
+    //1, 2 or 4. Up to the maximum the last prepare() allocated for it is applied by the next process(), so call it from
+    //that thread, above it by the next prepare()
+    void setOversamplingFactor (int newFactor) noexcept
+    {
+        jassert (newFactor == 1 || newFactor == 2 || newFactor == 4);
+        mOversamplingFactor = newFactor;
+    }
+
+    int getOversamplingFactor() const noexcept      { return mOversamplingFactor; }
+
+    //The highest factor the next prepare() allocates for, at least the factor itself
+    void setMaxOversamplingFactor (int newMaximum) noexcept
+    {
+        jassert (newMaximum == 1 || newMaximum == 2 || newMaximum == 4);
+        mMaxOversamplingFactor = newMaximum;
+    }
+
+    //Samples the output lags the input by, for the factor the engine is running at
+    int getLatencyInSamples() const noexcept        { return mEngine.getLatencyInSamples(); }
+
+    double getTailLengthSeconds() const             { return mParameters.getTailLengthSeconds(); }
+    bool isIdle() const noexcept                    { return mEngine.isIdle(); }
+
+    //Heap memory held, the processor object itself not included
+    size_t getAllocatedBytes() const noexcept       { return mEngine.getAllocatedBytes(); }
+
+   #if COOLCHORUS_SCOPE
+    //Modulation points for a scope, nullptr to stop them
+    void setScopeFeed (ScopeFeed* feed) noexcept    { mEngine.setScopeFeed (feed); }
+   #endif
+
+private:
+    //==============================================================================
+    ChorusEngine<SampleType> mEngine;
+    ChorusParameters mParameters;
+    int mOversamplingFactor = 1;
+    int mMaxOversamplingFactor = 1;
+
+    //The old parameters with the wet signal faded out, used for the samples left of a recall's fade out
+    ChorusParameters mRecallFrom;
+    int mRecallLength = 1;
+    int mRecallRemaining = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChorusProcessor)
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    ChorusState.cpp
+
+  ==============================================================================
+*/
+
+#include "ChorusState.h"
+
+//==============================================================================
+namespace
+{
+    void writeUint32 (char* destination, juce::uint32 value) noexcept
+    {
+        value = juce::ByteOrder::swapIfBigEndian (value);
+        std::memcpy (destination, &value, sizeof (value));
+    }
+
+    void writeUint16 (char* destination, juce::uint16 value) noexcept
+    {
+        value = juce::ByteOrder::swapIfBigEndian (value);
+        std::memcpy (destination, &value, sizeof (value));
+    }
+
+    void writeFloat (char* destination, float value) noexcept
+    {
+        juce::uint32 bits;
+        std::memcpy (&bits, &value, sizeof (bits));
+        writeUint32 (destination, bits);
+    }
+
+    juce::uint32 readUint32 (const char* source) noexcept
+    {
+        juce::uint32 value;
+        std::memcpy (&value, source, sizeof (value));
+        return juce::ByteOrder::swapIfBigEndian (value);
+    }
+
+    juce::uint16 readUint16 (const char* source) noexcept
+    {
+        juce::uint16 value;
+        std::memcpy (&value, source, sizeof (value));
+        return juce::ByteOrder::swapIfBigEndian (value);
+    }
+
+    float readFloat (const char* source) noexcept
+    {
+        const juce::uint32 bits = readUint32 (source);
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+}
+
+//==============================================================================
+const char* const ChorusState::parameterIDs[ChorusState::numParameters] = { "drywet", "depth", "rate", "phaseoffset", "feedback", "type",
+                                                                            "lfowaveform", "voices", "interpolation", "quality", "oversampling",
+                                                                            "lfosync", "syncrate" };
+
+int ChorusState::indexOf (const juce::String& parameterID)
+{
+    for (int i = 0; i < numParameters; ++i)
+        if (parameterID == parameterIDs[i])
+            return i;
+
+    return -1;
+}
+
+void ChorusState::writeTo (juce::MemoryBlock& destData) const
+{
+    jassert (numValues == numParameters);
+
+    destData.setSize ((size_t) blockSize);
+    char* const bytes = static_cast<char*> (destData.getData());
+
+    writeUint32 (bytes, magic);
+    writeUint16 (bytes + 4, (juce::uint16) currentVersion);
+    writeUint16 (bytes + 6, (juce::uint16) numParameters);
+
+    char* field = bytes + headerSize;
+
+    for (int i = 0; i < numParameters; ++i, field += 4)
+        writeFloat (field, values[i]);
+
+    writeFloat (field, lfoPhase);
+    writeUint32 (field + 4, (juce::uint32) program);
+}
+
+bool ChorusState::readFrom (const void* data, int sizeInBytes)
+{
+    const char* const bytes = static_cast<const char*> (data);
+
+    if (bytes == nullptr || sizeInBytes < headerSize || readUint32 (bytes) != magic)
+        return false;
+
+    //the version only tells what a block may have after program, every field up to there is found from numValues
+    const int storedValues = readUint16 (bytes + 6);
+
+    if (sizeInBytes < headerSize + (storedValues + 2) * 4)
+        return false;
+
+    const char* field = bytes + headerSize;
+    numValues = juce::jmin (storedValues, numParameters);
+
+    for (int i = 0; i < numValues; ++i)
+        values[i] = juce::jlimit (0.f, 1.f, readFloat (field + i * 4));
+
+    field += storedValues * 4;
+    lfoPhase = readFloat (field);
+    program = (int) readUint32 (field + 4);
+    return true;
+}
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    ChorusState.h
+
+    The plugin's saved state as a small versioned binary block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    What a session keeps of an instance: the normalised value of every
+    parameter, the factory preset last recalled and where the LFO was.
+
+    The binary form is a fixed layout that is read straight into place, with
+    nothing to parse, all of it little endian:
+
+        uint32  magic, "CCst"
+        uint16  version
+        uint16  numValues
+        float   values[numValues], normalised, in the order of parameterIDs
+        float   lfoPhase
+        int32   program
+
+    A later version only appends, to parameterIDs and after program, so any
+    version reads a block of any other. Values a block does not have are left
+    to the caller, the plugin sets those parameters to their defaults, and
+    whatever comes after the fields a version knows is skipped.
+*/
+struct ChorusState
+{
+    static constexpr juce::uint32 magic = 0x74734343; //"CCst" in the byte order of the block
+    static constexpr int currentVersion = 2;
+
+    //The parameters in the order of the values, new ones are only ever added at the end. Version 1 had the first 11
+    static constexpr int numParameters = 13;
+    static const char* const parameterIDs[numParameters];
+
+    //Bytes of a block written by this version
+    static constexpr int headerSize = 8;
+    static constexpr int blockSize = headerSize + (numParameters + 2) * 4;
+
+    //Index of an ID in parameterIDs, -1 for one that is not there
+    static int indexOf (const juce::String& parameterID);
+
+    void writeTo (juce::MemoryBlock& destData) const;
+
+    //False, and nothing changed, when data is not a state block or is cut short
+    bool readFrom (const void* data, int sizeInBytes);
+
+    //==============================================================================
+    float values[numParameters] = {};
+    int numValues = numParameters;  //the first numValues are set, after readFrom the ones the block had
+    float lfoPhase = 0;
+    int program = 0;
+};
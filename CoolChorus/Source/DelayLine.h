@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    DelayLine.h
+
+    Power of two ring buffer shared by the chorus voices.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "TraceZones.h"
+
+//==============================================================================
+/**
+    A circular delay buffer with numChannels interleaved samples per frame.
+
+    The length is a power of two and guardFrames frames past the end mirror
+    the start, so frames x .. x + guardFrames read contiguously from any masked
+    x. Frame n of read() is delayTrajectory[n] samples behind where frame n of
+    the next write() lands. prepare() only reallocates for a different size.
+*/
+template <typename SampleType>
+class DelayLine
+{
+public:
+    //frames past the end that mirror the start, enough for a 6 point interpolator
+    static constexpr int guardFrames = 5;
+    static constexpr size_t alignment = 64;
+
+    DelayLine() = default;
+
+    //Sizes the buffer for delays up to maximumDelayInSamples and clears it. This can allocate,
+    //so call it from prepareToPlay and never from the audio thread
+    void prepare(int maximumDelayInSamples, int numChannels)
+    {
+        jassert(maximumDelayInSamples > 0 && numChannels > 0);
+
+        mNumChannels = numChannels;
+        mSize = juce::nextPowerOfTwo(maximumDelayInSamples + guardFrames + 1);
+        mMask = mSize - 1;
+
+        const size_t bytesNeeded = getBufferBytes() + alignment - 1;
+
+        if (bytesNeeded != mAllocatedBytes)
+        {
+            mStorage.allocate(bytesNeeded, false);
+            mAllocatedBytes = bytesNeeded;
+        }
+
+        mBuffer = juce::snapPointerToAlignment(reinterpret_cast<SampleType*>(mStorage.get()), alignment);
+        reset();
+    }
+
+    void reset()
+    {
+        juce::zeromem(mBuffer, getBufferBytes());
+        mWritePosition = 0;
+    }
+
+    int getSize() const noexcept             { return mSize; }
+    int getMask() const noexcept             { return mMask; }
+    int getNumChannels() const noexcept      { return mNumChannels; }
+    int getWritePosition() const noexcept    { return mWritePosition; }
+
+    //Longest delay that can be read without running into frames that are about to be overwritten
+    int getMaximumDelayInSamples() const noexcept { return mSize - guardFrames - 1; }
+
+    //Heap memory held, including the alignment slack
+    size_t getAllocatedBytes() const noexcept { return mAllocatedBytes; }
+
+    const SampleType* getReadPointer() const noexcept { return mBuffer; }
+
+    //Appends numFrames interleaved frames and advances the write position
+    void write(const SampleType* source, int numFrames) noexcept
+    {
+        COOLCHORUS_TRACE_ZONE("Delay write");
+
+        jassert(numFrames <= mSize);
+
+        const int start = mWritePosition;
+        const int firstSegment = juce::jmin(numFrames, mSize - start);
+        const int secondSegment = numFrames - firstSegment;
+        const size_t frameBytes = sizeof(SampleType) * (size_t) mNumChannels;
+
+        std::memcpy(mBuffer + start * mNumChannels, source, frameBytes * (size_t) firstSegment);
+
+        if (secondSegment > 0)
+            std::memcpy(mBuffer, source + firstSegment * mNumChannels, frameBytes * (size_t) secondSegment);
+
+        //refresh the mirrored guard whenever the first frames were touched
+        if (start < guardFrames || secondSegment > 0)
+            std::memcpy(mBuffer + mSize * mNumChannels, mBuffer, frameBytes * (size_t) guardFrames);
+
+        mWritePosition = (start + numFrames) & mMask;
+    }
+
+    //Linear interpolated read of one channel, see the class description for where frame n is read from
+    void read(SampleType* destination, const SampleType* delayTrajectory, int numFrames, int channel = 0) const noexcept
+    {
+        jassert(juce::isPositiveAndBelow(channel, mNumChannels));
+
+        const SampleType* buffer = mBuffer + channel;
+
+        for (int n = 0; n < numFrames; ++n)
+        {
+            jassert(delayTrajectory[n] > (SampleType) (n + 1) && delayTrajectory[n] <= (SampleType) getMaximumDelayInSamples());
+
+            //position = writePosition + n - delay, split so the integer part never loses precision in a float
+            const int delayInteger = (int) delayTrajectory[n];
+            const SampleType fraction = (SampleType) 1 - (delayTrajectory[n] - (SampleType) delayInteger);
+            const int index = (mWritePosition + n - delayInteger - 1) & mMask;
+
+            const SampleType x0 = buffer[index * mNumChannels];
+            const SampleType x1 = buffer[(index + 1) * mNumChannels];
+            destination[n] = x0 + fraction * (x1 - x0);
+        }
+    }
+
+private:
+    //==============================================================================
+    size_t getBufferBytes() const noexcept { return sizeof(SampleType) * (size_t) ((mSize + guardFrames) * mNumChannels); }
+
+    juce::HeapBlock<char> mStorage;
+    SampleType* mBuffer = nullptr; //mStorage rounded up to the alignment
+    size_t mAllocatedBytes = 0;
+    int mSize = 0;
+    int mMask = 0;
+    int mNumChannels = 1;
+    int mWritePosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DelayLine)
+};
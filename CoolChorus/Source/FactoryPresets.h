@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    FactoryPresets.h
+
+    The bank of presets the plugin offers as its programs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ChorusLFO.h"
+#include "Interpolators.h"
+#include "ChorusKernels.h"
+
+//==============================================================================
+/**
+    One factory preset, in the parameters' own units. Quality and Oversampling
+    are left out, they are a choice of CPU for the session and not part of the
+    sound, and so is the LFO Sync, which belongs to the song. Recalling a preset
+    keeps them.
+*/
+struct FactoryPreset
+{
+    const char* name;
+    float dryWet;
+    float depth;
+    float rate;         //Hz
+    float phaseOffset;
+    float feedback;
+    int type;
+    int waveform;
+    int numVoices;
+    int interpolation;
+};
+
+//A constant table, recalling one of them is a handful of parameter writes with nothing allocated
+namespace FactoryPresets
+{
+    constexpr FactoryPreset presets[] =
+    {
+        { "Default",          0.5f,  0.5f,  10.f,  0.f,   0.5f,  ChorusType::chorus,  ChorusLFO::sineWave,     1, Interpolation::linear },
+        { "Classic Chorus",   0.5f,  0.35f, 0.8f,  0.5f,  0.1f,  ChorusType::chorus,  ChorusLFO::sineWave,     2, Interpolation::hermite },
+        { "Wide Ensemble",    0.6f,  0.45f, 0.5f,  1.f,   0.15f, ChorusType::chorus,  ChorusLFO::triangleWave, 6, Interpolation::hermite },
+        { "Subtle Doubler",   0.3f,  0.15f, 0.3f,  0.75f, 0.f,   ChorusType::chorus,  ChorusLFO::sineWave,     1, Interpolation::lagrange },
+        { "Warble",           0.5f,  0.8f,  5.f,   0.25f, 0.3f,  ChorusType::chorus,  ChorusLFO::randomWave,   3, Interpolation::hermite },
+        { "Jet Flanger",      0.5f,  0.7f,  0.2f,  0.f,   0.85f, ChorusType::flanger, ChorusLFO::triangleWave, 1, Interpolation::thiran },
+        { "Stereo Flanger",   0.5f,  0.5f,  0.4f,  0.5f,  0.6f,  ChorusType::flanger, ChorusLFO::sineWave,     1, Interpolation::thiran },
+        { "Saw Sweep",        0.5f,  0.6f,  1.5f,  0.5f,  0.4f,  ChorusType::flanger, ChorusLFO::sawWave,      2, Interpolation::lagrange6 }
+    };
+
+    constexpr int numPresets = (int) (sizeof (presets) / sizeof (presets[0]));
+}
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    Interpolators.h
+
+    Fractional delay interpolators for reading the chorus delay line.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StereoFrame.h"
+
+//==============================================================================
+/**
+    Interpolation policies for the voice kernel, which is a template on them.
+
+    A policy reads numPoints consecutive frames from pointsBefore frames before
+    x0 and interpolates between x0 and x1 at fraction, 0 at x0 and 1 at x1.
+    process() also gets the lane's previous output, the Thiran allpass state.
+    CoolChorusCLI interpbench prints the response and cost of each.
+*/
+namespace Interpolation
+{
+    enum Mode
+    {
+        linear = 0,
+        hermite,
+        lagrange,
+        thiran,
+        lagrange6,
+        numModes
+    };
+
+    inline juce::StringArray getModeNames() { return { "Linear", "Hermite", "Lagrange", "Thiran", "Lagrange 6" }; }
+}
+
+//==============================================================================
+/** Straight line between x0 and x1, the original read. */
+struct LinearInterpolator
+{
+    static constexpr int numPoints = 2;
+    static constexpr int pointsBefore = 0;
+
+    template <typename Frame>
+    static Frame process(const Frame* x, Frame fraction, Frame) noexcept
+    {
+        return x[0] + fraction * (x[1] - x[0]);
+    }
+};
+
+//==============================================================================
+/** Catmull-Rom cubic Hermite through x-1 .. x2. */
+struct HermiteInterpolator
+{
+    static constexpr int numPoints = 4;
+    static constexpr int pointsBefore = 1;
+
+    template <typename Frame>
+    static Frame process(const Frame* x, Frame fraction, Frame) noexcept
+    {
+        using SampleType = typename Frame::SampleType;
+
+        const Frame half = Frame::expand((SampleType) 0.5);
+        const Frame xm1 = x[0], x0 = x[1], x1 = x[2], x2 = x[3];
+
+        const Frame c1 = half * (x1 - xm1);
+        const Frame c2 = xm1 - Frame::expand((SampleType) 2.5) * x0 + Frame::expand((SampleType) 2) * x1 - half * x2;
+        const Frame c3 = half * (x2 - xm1) + Frame::expand((SampleType) 1.5) * (x0 - x1);
+
+        return ((c3 * fraction + c2) * fraction + c1) * fraction + x0;
+    }
+};
+
+//==============================================================================
+/** Third order Lagrange polynomial through x-1 .. x2. */
+struct LagrangeInterpolator
+{
+    static constexpr int numPoints = 4;
+    static constexpr int pointsBefore = 1;
+
+    template <typename Frame>
+    static Frame process(const Frame* x, Frame fraction, Frame) noexcept
+    {
+        using SampleType = typename Frame::SampleType;
+
+        const Frame one = Frame::expand((SampleType) 1);
+        const Frame dp1 = fraction + one;
+        const Frame dm1 = fraction - one;
+        const Frame dm2 = fraction - Frame::expand((SampleType) 2);
+
+        //weights -d(d-1)(d-2)/6, (d+1)(d-1)(d-2)/2, -(d+1)d(d-2)/2, (d+1)d(d-1)/6 with shared products
+        const Frame dm1dm2 = dm1 * dm2;
+        const Frame dp1d = dp1 * fraction;
+
+        return Frame::expand((SampleType) -1 / (SampleType) 6) * fraction * dm1dm2 * x[0]
+             + Frame::expand((SampleType) 0.5) * dp1 * dm1dm2 * x[1]
+             + Frame::expand((SampleType) -0.5) * dp1d * dm2 * x[2]
+             + Frame::expand((SampleType) 1 / (SampleType) 6) * dp1d * dm1 * x[3];
+    }
+};
+
+//==============================================================================
+/** Fifth order Lagrange polynomial through x-2 .. x3. */
+struct Lagrange6Interpolator
+{
+    static constexpr int numPoints = 6;
+    static constexpr int pointsBefore = 2;
+
+    template <typename Frame>
+    static Frame process(const Frame* x, Frame fraction, Frame) noexcept
+    {
+        using SampleType = typename Frame::SampleType;
+
+        //the distances from the six points, d+2 .. d-3
+        const Frame a = fraction + Frame::expand((SampleType) 2);
+        const Frame b = fraction + Frame::expand((SampleType) 1);
+        const Frame c = fraction;
+        const Frame d = fraction - Frame::expand((SampleType) 1);
+        const Frame e = fraction - Frame::expand((SampleType) 2);
+        const Frame f = fraction - Frame::expand((SampleType) 3);
+
+        //each weight is the product of every distance but its own over a constant, built from shared prefix and suffix products
+        const Frame ab = a * b, abc = ab * c, abcd = abc * d;
+        const Frame ef = e * f, def = d * ef, cdef = c * def;
+
+        return Frame::expand((SampleType) -1 / (SampleType) 120) * b * cdef * x[0]
+             + Frame::expand((SampleType) 1 / (SampleType) 24) * a * cdef * x[1]
+             + Frame::expand((SampleType) -1 / (SampleType) 12) * ab * def * x[2]
+             + Frame::expand((SampleType) 1 / (SampleType) 12) * abc * ef * x[3]
+             + Frame::expand((SampleType) -1 / (SampleType) 24) * abcd * f * x[4]
+             + Frame::expand((SampleType) 1 / (SampleType) 120) * abcd * e * x[5];
+    }
+};
+
+//==============================================================================
+/**
+    First order Thiran allpass, on x0/x1 for low fractions and on x1/x2 for
+    high ones so its delay stays within 0.618 .. 1.618 samples, blended over
+    fractions 0.282 .. 0.482.
+*/
+struct ThiranInterpolator
+{
+    static constexpr int numPoints = 4;
+    static constexpr int pointsBefore = 1;
+
+    template <typename Frame>
+    static Frame process(const Frame* x, Frame fraction, Frame previousOutput) noexcept
+    {
+        using SampleType = typename Frame::SampleType;
+
+        const Frame zero = Frame::expand((SampleType) 0);
+        const Frame one = Frame::expand((SampleType) 1);
+        const Frame two = Frame::expand((SampleType) 2);
+        const Frame three = Frame::expand((SampleType) 3);
+
+        const Frame lowerEta = fraction / (two - fraction);
+        const Frame upperEta = (fraction - one) / (three - fraction);
+        const Frame lower = x[1] + lowerEta * (x[2] - previousOutput);
+        const Frame upper = x[2] + upperEta * (x[3] - previousOutput);
+
+        //0 below fraction 0.282, 1 above 0.482
+        Frame blend = (fraction - Frame::expand((SampleType) 0.282)) * Frame::expand((SampleType) 5);
+        blend = Frame::selectLessThan(blend, zero, zero, blend);
+        blend = Frame::selectLessThan(one, blend, one, blend);
+
+        return lower + blend * (upper - lower);
+    }
+};
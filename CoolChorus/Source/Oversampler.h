@@ -0,0 +1,300 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+
+    Polyphase half-band filters that run the delay loop at 2x or 4x.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "StereoFrame.h"
+
+namespace Oversampling
+{
+    enum Mode
+    {
+        off = 0,
+        twoTimes,
+        fourTimes,
+        numModes
+    };
+
+    inline juce::StringArray getModeNames() { return { "Off", "2x", "4x" }; }
+
+    inline int getFactor(int mode) noexcept { return mode == fourTimes ? 4 : (mode == twoTimes ? 2 : 1); }
+}
+
+//==============================================================================
+/**
+    Side taps of the half-band lowpass stages, nearest the centre first, the
+    centre tap is 0.5 and every other tap zero. The first stage, base rate to
+    2x, passes to 0.2 of the 2x rate and stops from 0.3 at -81 dB. The second,
+    2x to 4x, passes to 0.1 and stops from 0.4 at -89 dB.
+*/
+namespace HalfbandCoefficients
+{
+    constexpr int firstStageSize = 12;
+    constexpr double firstStage[firstStageSize] = { 0.3164571530206266, -0.10065670141989715, 0.054943907772944237, -0.033978732225804886,
+                                                    0.021711842710725255, -0.013787094923741142, 0.0084982426864224671, -0.0049870509231878099,
+                                                    0.0027283620871067964, -0.0013514572110044801, 0.00057643337895951069, -0.00019770076399563548 };
+
+    constexpr int secondStageSize = 4;
+    constexpr double secondStage[secondStageSize] = { 0.30316060829803931, -0.067657331856172176, 0.016949009106420772, -0.0024680272216466587 };
+}
+
+//==============================================================================
+/**
+    Doubles the rate of interleaved stereo frames with a half-band filter of
+    numTaps side taps, without forming the zero stuffed signal.
+*/
+template <typename SampleType, int numTaps>
+class HalfbandUpsampler
+{
+public:
+    using Frame = StereoFrame<SampleType>;
+
+    //Frames of history, and output samples (at the doubled rate) the filter is behind by
+    static constexpr int historyFrames = 2 * numTaps - 1;
+    static constexpr int latency = 2 * numTaps - 1;
+
+    void prepare(const double* taps, int maxInputFrames)
+    {
+        for (int i = 0; i < numTaps; ++i)
+            mTaps[i] = (SampleType) (2.0 * taps[i]); //the gain lost to the zero stuffing
+
+        mBuffer.allocate((size_t) ((historyFrames + maxInputFrames) * 2), true);
+        mMaxInputFrames = maxInputFrames;
+    }
+
+    void reset() noexcept
+    {
+        juce::FloatVectorOperations::clear(mBuffer.get(), historyFrames * 2);
+    }
+
+    //numFrames frames in, 2 * numFrames out
+    void process(const SampleType* input, SampleType* output, int numFrames) noexcept
+    {
+        jassert(numFrames <= mMaxInputFrames);
+
+        SampleType* const x = mBuffer + historyFrames * 2;
+        std::memcpy(x, input, sizeof(SampleType) * (size_t) (numFrames * 2));
+
+        for (int k = 0; k < numFrames; ++k)
+        {
+            //output 2k + 1 is input frame k - (numTaps - 1), output 2k falls half way between it and the frame before
+            const SampleType* const centre = x + (k - (numTaps - 1)) * 2;
+            Frame sum = Frame::expand((SampleType) 0);
+
+            for (int i = 0; i < numTaps; ++i)
+                sum = sum + Frame::expand(mTaps[i]) * (Frame::load(centre + i * 2) + Frame::load(centre - (i + 1) * 2));
+
+            sum.store(output + k * 4);
+            Frame::load(centre).store(output + k * 4 + 2);
+        }
+
+        std::memmove(mBuffer.get(), mBuffer + numFrames * 2, sizeof(SampleType) * (size_t) (historyFrames * 2));
+    }
+
+    size_t getAllocatedBytes() const noexcept { return sizeof(SampleType) * (size_t) ((historyFrames + mMaxInputFrames) * 2); }
+
+private:
+    SampleType mTaps[numTaps] = {};
+    juce::HeapBlock<SampleType> mBuffer;
+    int mMaxInputFrames = 0;
+};
+
+//==============================================================================
+/**
+    Halves the rate of interleaved stereo frames with a half-band filter of
+    numTaps side taps per half, computing only the frames it keeps.
+
+    setExtraDelay() holds the input back by up to the maxExtraDelay frames
+    prepare() made room for, which the 4x oversampler uses to land its latency
+    on a whole sample of the base rate.
+*/
+template <typename SampleType, int numTaps>
+class HalfbandDownsampler
+{
+public:
+    using Frame = StereoFrame<SampleType>;
+
+    //Input samples (at the higher rate) the filter is behind by, without the extra delay
+    static constexpr int latency = 2 * numTaps - 1;
+
+    void prepare(const double* taps, int maxOutputFrames, int maxExtraDelay)
+    {
+        for (int i = 0; i < numTaps; ++i)
+            mTaps[i] = (SampleType) taps[i];
+
+        mExtraDelay = 0;
+        mMaxExtraDelay = maxExtraDelay;
+        mHistoryFrames = 4 * numTaps - 2 + maxExtraDelay;
+        mBuffer.allocate((size_t) ((mHistoryFrames + 2 * maxOutputFrames) * 2), true);
+        mMaxOutputFrames = maxOutputFrames;
+    }
+
+    //Allocates nothing, follow it with reset() as the frames held back no longer line up
+    void setExtraDelay(int extraDelay) noexcept
+    {
+        jassert(extraDelay >= 0 && extraDelay <= mMaxExtraDelay);
+        mExtraDelay = juce::jlimit(0, mMaxExtraDelay, extraDelay);
+    }
+
+    void reset() noexcept
+    {
+        juce::FloatVectorOperations::clear(mBuffer.get(), mHistoryFrames * 2);
+    }
+
+    //2 * numFrames frames in, numFrames out
+    void process(const SampleType* input, SampleType* output, int numFrames) noexcept
+    {
+        jassert(numFrames <= mMaxOutputFrames);
+
+        SampleType* const x = mBuffer + mHistoryFrames * 2;
+        std::memcpy(x, input, sizeof(SampleType) * (size_t) (numFrames * 4));
+
+        const Frame half = Frame::expand((SampleType) 0.5);
+
+        for (int k = 0; k < numFrames; ++k)
+        {
+            //output k is centred on input frame 2k - latency
+            const SampleType* const centre = x + (2 * k - latency - mExtraDelay) * 2;
+            Frame sum = half * Frame::load(centre);
+
+            for (int i = 0; i < numTaps; ++i)
+                sum = sum + Frame::expand(mTaps[i]) * (Frame::load(centre + (2 * i + 1) * 2) + Frame::load(centre - (2 * i + 1) * 2));
+
+            sum.store(output + k * 2);
+        }
+
+        std::memmove(mBuffer.get(), mBuffer + numFrames * 4, sizeof(SampleType) * (size_t) (mHistoryFrames * 2));
+    }
+
+    size_t getAllocatedBytes() const noexcept { return sizeof(SampleType) * (size_t) ((mHistoryFrames + 2 * mMaxOutputFrames) * 2); }
+
+private:
+    SampleType mTaps[numTaps] = {};
+    juce::HeapBlock<SampleType> mBuffer;
+    int mHistoryFrames = 0;
+    int mExtraDelay = 0;
+    int mMaxExtraDelay = 0;
+    int mMaxOutputFrames = 0;
+};
+
+//==============================================================================
+/**
+    Up and down by 2 or 4 for one pair of channels, as interleaved frames.
+    prepare() allocates for both factors and the longest block, so setFactor()
+    switches between them on the audio thread. The round trip is linear phase
+    and lags by 23 base samples at 2x and 27 at 4x.
+*/
+template <typename SampleType>
+class Oversampler
+{
+public:
+    //Samples at the base rate between a frame going up and coming back down
+    static constexpr int getLatencyInSamples(int factor) noexcept
+    {
+        //the first stage's round trip in samples at 2x, the second one's at 4x
+        const int firstStage = FirstUpsampler::latency + FirstDownsampler::latency;
+        const int secondStage = SecondUpsampler::latency + SecondDownsampler::latency;
+
+        if (factor == 4)
+            return (2 * (firstStage + 1) + secondStage) / 4;
+
+        return factor == 2 ? firstStage / 2 : 0;
+    }
+
+    //Allocates for blocks of up to maxLoopFrames at the higher rate, at either factor, and starts at factor
+    void prepare(int factor, int maxLoopFrames)
+    {
+        //the most the first stage sees is at 2x, the second stage's 2x side holds as many frames
+        const int maxHalfFrames = maxLoopFrames / 2;
+
+        mFirstUp.prepare(HalfbandCoefficients::firstStage, maxHalfFrames);
+        mFirstDown.prepare(HalfbandCoefficients::firstStage, maxHalfFrames, 1);
+        mSecondUp.prepare(HalfbandCoefficients::secondStage, maxHalfFrames);
+        mSecondDown.prepare(HalfbandCoefficients::secondStage, maxHalfFrames, 0);
+        mMiddleBuffer.allocate((size_t) (maxHalfFrames * 2), true);
+        mUpsampledBuffer.allocate((size_t) (maxLoopFrames * 2), true);
+        mMaxLoopFrames = maxLoopFrames;
+
+        setFactor(factor);
+    }
+
+    //2 or 4, allocates nothing and clears the filters
+    void setFactor(int factor) noexcept
+    {
+        jassert(factor == 2 || factor == 4);
+        mFactor = (factor == 4) ? 4 : 2;
+        mFirstDown.setExtraDelay(mFactor == 4 ? 1 : 0);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        mFirstUp.reset();
+        mFirstDown.reset();
+        mSecondUp.reset();
+        mSecondDown.reset();
+    }
+
+    int getFactor() const noexcept { return mFactor; }
+
+    //numFrames frames at the base rate in, returns factor * numFrames frames at the higher rate
+    const SampleType* upsample(const SampleType* input, int numFrames) noexcept
+    {
+        if (mFactor == 4)
+        {
+            mFirstUp.process(input, mMiddleBuffer, numFrames);
+            mSecondUp.process(mMiddleBuffer, mUpsampledBuffer, numFrames * 2);
+        }
+        else
+        {
+            mFirstUp.process(input, mUpsampledBuffer, numFrames);
+        }
+
+        return mUpsampledBuffer;
+    }
+
+    //factor * numFrames frames at the higher rate in, numFrames frames at the base rate out
+    void downsample(const SampleType* input, SampleType* output, int numFrames) noexcept
+    {
+        if (mFactor == 4)
+        {
+            mSecondDown.process(input, mMiddleBuffer, numFrames * 2);
+            mFirstDown.process(mMiddleBuffer, output, numFrames);
+        }
+        else
+        {
+            mFirstDown.process(input, output, numFrames);
+        }
+    }
+
+    size_t getAllocatedBytes() const noexcept
+    {
+        return mFirstUp.getAllocatedBytes() + mFirstDown.getAllocatedBytes()
+             + mSecondUp.getAllocatedBytes() + mSecondDown.getAllocatedBytes()
+             + sizeof(SampleType) * (size_t) (mMaxLoopFrames / 2 * 2 + mMaxLoopFrames * 2);
+    }
+
+private:
+    using FirstUpsampler = HalfbandUpsampler<SampleType, HalfbandCoefficients::firstStageSize>;
+    using FirstDownsampler = HalfbandDownsampler<SampleType, HalfbandCoefficients::firstStageSize>;
+    using SecondUpsampler = HalfbandUpsampler<SampleType, HalfbandCoefficients::secondStageSize>;
+    using SecondDownsampler = HalfbandDownsampler<SampleType, HalfbandCoefficients::secondStageSize>;
+
+    FirstUpsampler mFirstUp;
+    FirstDownsampler mFirstDown;
+    SecondUpsampler mSecondUp;
+    SecondDownsampler mSecondDown;
+
+    juce::HeapBlock<SampleType> mMiddleBuffer;      //the 2x frames between the stages at 4x
+    juce::HeapBlock<SampleType> mUpsampledBuffer;
+    int mMaxLoopFrames = 0;
+    int mFactor = 2;
+};
@@ -12,11 +12,23 @@
 //==============================================================================
 CoolChorusAudioProcessorEditor::CoolChorusAudioProcessorEditor (CoolChorusAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
+     #if COOLCHORUS_SCOPE
+      , mScope (p.getScopeFeed())
+     #endif
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (600, 250);
+   #if COOLCHORUS_SCOPE
+    addAndMakeVisible(mScope);
+    setSize (600, 250 + optionsRowHeight + scopeHeight);
+   #else
+    setSize (600, 250 + optionsRowHeight);
+   #endif
     InitializeUIElements();
+
+   #if COOLCHORUS_TELEMETRY
+    startTimerHz(10);
+   #endif
 }
 
 CoolChorusAudioProcessorEditor::~CoolChorusAudioProcessorEditor()
@@ -26,11 +38,11 @@ CoolChorusAudioProcessorEditor::~CoolChorusAudioProcessorEditor()
 //==============================================================================
 void CoolChorusAudioProcessorEditor::InitializeUIElements()
 {
-    InitializeSlider(&mDryWetSlider, 0);
-    InitializeSlider(&mDepthSlider, 1);
-    InitializeSlider(&mRateSlider, 2);
-    InitializeSlider(&mPhaseOffsetSlider, 3);
-    InitializeSlider(&mFeedbackSlider, 4);
+    InitializeSlider(&mDryWetSlider, mDryWetAttachment, "drywet");
+    InitializeSlider(&mDepthSlider, mDepthAttachment, "depth");
+    InitializeSlider(&mRateSlider, mRateAttachment, "rate");
+    InitializeSlider(&mPhaseOffsetSlider, mPhaseOffsetAttachment, "phaseoffset");
+    InitializeSlider(&mFeedbackSlider, mFeedbackAttachment, "feedback");
     
     InitializeLabel(&mDryWetLabel, "Mix");
     InitializeLabel(&mDepthLabel, "Depth");
@@ -38,40 +50,77 @@ void CoolChorusAudioProcessorEditor::InitializeUIElements()
     InitializeLabel(&mPhaseOffsetLabel, "Phase Offset");
     InitializeLabel(&mFeedbackLabel, "Feedback");
 
-    auto& params = processor.getParameters();
     //Type Parameter
-    AudioParameterInt* typeParameter = (AudioParameterInt*)params.getUnchecked(5);
     mTypeBox.addItem("Chorus", 1);
     mTypeBox.addItem("Flanger", 2);
-    addAndMakeVisible(mTypeBox);
-    
-    mTypeBox.onChange = [this, typeParameter]
+    InitializeComboBox(&mTypeBox, mTypeAttachment, "type");
+
+    //LFO Waveform Parameter
+    InitializeComboBox(&mWaveformBox, mWaveformAttachment, "lfowaveform");
+
+    //Voices Parameter, one item per count so the item index follows the parameter's range
+    if (auto* voicesParameter = dynamic_cast<AudioParameterInt*>(findParameter("voices")))
+        for (int voices = voicesParameter->getRange().getStart(); voices <= voicesParameter->getRange().getEnd(); voices++)
+            mVoicesBox.addItem(String(voices) + (voices == 1 ? " Voice" : " Voices"), voices);
+    InitializeComboBox(&mVoicesBox, mVoicesAttachment, "voices");
+
+    //Interpolation and Quality Parameters
+    InitializeComboBox(&mInterpolationBox, mInterpolationAttachment, "interpolation");
+    InitializeComboBox(&mQualityBox, mQualityAttachment, "quality");
+
+    //Oversampling Parameter, the processor switches to a new factor at its next block
+    InitializeComboBox(&mOversamplingBox, mOversamplingAttachment, "oversampling");
+
+    //LFO Sync and Sync Rate Parameters, the Rate slider has no say while the LFO follows the tempo. The attachment
+    //changes the box before onChange runs, for a restored state as much as for a click
+    mLFOSyncBox.onChange = [this]
     {
-        typeParameter->beginChangeGesture();
-        *typeParameter = mTypeBox.getSelectedItemIndex();
-        typeParameter->endChangeGesture();
+        mRateSlider.setEnabled(mLFOSyncBox.getSelectedItemIndex() == TempoSync::free);
+        mSyncRateBox.setEnabled(mLFOSyncBox.getSelectedItemIndex() == TempoSync::tempo);
     };
-    
-    mTypeBox.setSelectedItemIndex(*typeParameter);
+    InitializeComboBox(&mLFOSyncBox, mLFOSyncAttachment, "lfosync");
+    InitializeComboBox(&mSyncRateBox, mSyncRateAttachment, "syncrate");
+
+    mRateSlider.setEnabled(mLFOSyncBox.getSelectedItemIndex() == TempoSync::free);
+    mSyncRateBox.setEnabled(mLFOSyncBox.getSelectedItemIndex() == TempoSync::tempo);
 }
 
-void CoolChorusAudioProcessorEditor::InitializeSlider(Slider* slider, int paramIndex)
+RangedAudioParameter* CoolChorusAudioProcessorEditor::findParameter(const String& parameterID) const
 {
-    auto& params = processor.getParameters();
-    jassert(paramIndex >= 0 && paramIndex < params.size());
-    AudioParameterFloat* parameter = (AudioParameterFloat*)params.getUnchecked(paramIndex);
+    for (auto* parameter : audioProcessor.getParameters())
+        if (auto* ranged = dynamic_cast<RangedAudioParameter*>(parameter))
+            if (ranged->getParameterID() == parameterID)
+                return ranged;
+
+    jassertfalse;
+    return nullptr;
+}
+
+void CoolChorusAudioProcessorEditor::InitializeSlider(Slider* slider, std::unique_ptr<SliderParameterAttachment>& attachment, const String& parameterID)
+{
+    RangedAudioParameter* parameter = findParameter(parameterID);
     
-    jassert(slider != nullptr);
+    jassert(slider != nullptr && parameter != nullptr);
     slider->setSliderStyle(Slider::SliderStyle::RotaryVerticalDrag);
     slider->setTextBoxStyle(Slider::TextEntryBoxPosition::TextBoxBelow, false, 100, 15);
     slider->setNumDecimalPlacesToDisplay(3);
-    
-    slider->setRange(parameter->range.start, parameter->range.end);
-    slider->setValue(*parameter);
     addAndMakeVisible(slider);
-    slider->onValueChange = [this, parameter, slider] { *parameter = slider->getValue(); };
-    slider->onDragStart = [parameter] { parameter->beginChangeGesture(); };
-    slider->onDragEnd = [parameter] { parameter->endChangeGesture(); };
+
+    //takes the range from the parameter and wraps every drag in a change gesture
+    attachment = std::make_unique<SliderParameterAttachment>(*parameter, *slider);
+}
+
+void CoolChorusAudioProcessorEditor::InitializeComboBox(ComboBox* box, std::unique_ptr<ComboBoxParameterAttachment>& attachment, const String& parameterID)
+{
+    RangedAudioParameter* parameter = findParameter(parameterID);
+
+    jassert(box != nullptr && parameter != nullptr);
+    if (auto* choiceParameter = dynamic_cast<AudioParameterChoice*>(parameter))
+        box->addItemList(choiceParameter->choices, 1);
+    addAndMakeVisible(box);
+
+    //item i is the parameter's i-th value, so the boxes need as many items as their parameter has steps
+    attachment = std::make_unique<ComboBoxParameterAttachment>(*parameter, *box);
 }
 
 void CoolChorusAudioProcessorEditor::InitializeLabel(Label* label, const String& labelText)
@@ -85,14 +134,58 @@ void CoolChorusAudioProcessorEditor::InitializeLabel(Label* label, const String&
 void CoolChorusAudioProcessorEditor::paint (juce::Graphics& g)
 {
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
+
+   #if COOLCHORUS_TELEMETRY
+    paintLoadMeter(g, mLoadMeterArea);
+   #endif
+}
+
+#if COOLCHORUS_TELEMETRY
+void CoolChorusAudioProcessorEditor::timerCallback()
+{
+    audioProcessor.getTelemetry().update();
+    repaint(mLoadMeterArea);
+}
+
+//The figures on the left, the load histogram on the right with one bar per 5% of the deadline
+void CoolChorusAudioProcessorEditor::paintLoadMeter (juce::Graphics& g, juce::Rectangle<int> area)
+{
+    const TelemetrySnapshot& snapshot = audioProcessor.getTelemetry().getSnapshot();
+    const Colour textColour = getLookAndFeel().findColour(Label::textColourId);
+
+    auto textArea = area.removeFromLeft(area.getWidth() / 2);
+    g.setColour(textColour);
+    g.setFont(12.f);
+    g.drawFittedText("Load " + String(snapshot.recentLoad, 1) + "%  peak " + String(snapshot.recentPeakLoad, 1)
+                         + "%  worst " + String(snapshot.worstLoad, 1) + "% (" + String(snapshot.worstBlockMicroseconds, 0) + " us)"
+                         + (snapshot.numOverruns > 0 ? "  overruns " + String(snapshot.numOverruns) : String()),
+                     textArea, Justification::centredLeft, 1);
+
+    juce::int64 tallest = 1;
+    for (auto count : snapshot.loadHistogram)
+        tallest = jmax(tallest, count);
+
+    const float barWidth = (float) area.getWidth() / (float) TelemetrySnapshot::numLoadBins;
+    for (int bin = 0; bin < TelemetrySnapshot::numLoadBins; bin++)
+    {
+        //square root scale, so the rare slow blocks still show next to the common ones
+        const float height = (float) area.getHeight() * std::sqrt((float) snapshot.loadHistogram[(size_t) bin] / (float) tallest);
+        g.setColour(bin == TelemetrySnapshot::numLoadBins - 1 ? Colours::red : textColour.withAlpha(0.6f));
+        g.fillRect((float) area.getX() + bin * barWidth + 1.f, (float) area.getBottom() - height, barWidth - 2.f, height);
+    }
 }
+#endif
 
 void CoolChorusAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor...
     const int centerX = getWidth()/2;
-    const int centerY = getHeight()/2;
+   #if COOLCHORUS_SCOPE
+    const int centerY = (getHeight() - optionsRowHeight - scopeHeight)/2;
+   #else
+    const int centerY = (getHeight() - optionsRowHeight)/2;
+   #endif
     const int compWidth = 100;
     
     mDryWetSlider.setBounds(centerX - 50 - compWidth*2, centerY - 70, compWidth, 100);
@@ -108,5 +201,20 @@ void CoolChorusAudioProcessorEditor::resized()
     mFeedbackLabel.setBounds(centerX - 50 + compWidth*2, centerY + 40, compWidth, 30);
     
     mTypeBox.setBounds(centerX - 50, centerY - 110, compWidth, 20);
+    mWaveformBox.setBounds(centerX - 50 + compWidth, centerY - 110, compWidth, 20);
+    mVoicesBox.setBounds(centerX - 50 - compWidth, centerY - 110, compWidth, 20);
+    mInterpolationBox.setBounds(centerX - 50 + compWidth*2, centerY - 110, compWidth, 20);
+    mQualityBox.setBounds(centerX - 50 - compWidth*2, centerY - 110, compWidth, 20);
+    mOversamplingBox.setBounds(centerX - 50 + compWidth*2, centerY + 75, compWidth, 20);
+    mLFOSyncBox.setBounds(centerX - 50, centerY + 75, compWidth, 20);
+    mSyncRateBox.setBounds(centerX - 50 + compWidth, centerY + 75, compWidth, 20);
+
+   #if COOLCHORUS_SCOPE
+    mScope.setBounds(getLocalBounds().withTop(centerY + 75 + optionsRowHeight).withTrimmedBottom(20).reduced(10, 2));
+   #endif
+
+   #if COOLCHORUS_TELEMETRY
+    mLoadMeterArea = getLocalBounds().removeFromBottom(20).reduced(10, 2);
+   #endif
 
 }
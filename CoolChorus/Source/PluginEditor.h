@@ -10,6 +10,7 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "ScopeComponent.h"
 
 //==============================================================================
 /**
@@ -17,6 +18,9 @@
 using namespace juce;
 
 class CoolChorusAudioProcessorEditor  : public juce::AudioProcessorEditor
+                                     #if COOLCHORUS_TELEMETRY
+                                      , private juce::Timer
+                                     #endif
 {
 public:
     CoolChorusAudioProcessorEditor (CoolChorusAudioProcessor&);
@@ -27,13 +31,25 @@ public:
     void resized() override;
     
     void InitializeUIElements();
-    void InitializeSlider(Slider* slider, int parameterIndex);
+    void InitializeSlider(Slider* slider, std::unique_ptr<SliderParameterAttachment>& attachment, const String& parameterID);
+    void InitializeComboBox(ComboBox* box, std::unique_ptr<ComboBoxParameterAttachment>& attachment, const String& parameterID);
     void InitializeLabel(Label* label, const String& labelText);
 
 private:
+   #if COOLCHORUS_TELEMETRY
+    //Load meter along the bottom edge, drained from the processor's telemetry ten times a second
+    void timerCallback() override;
+    void paintLoadMeter (juce::Graphics& g, juce::Rectangle<int> area);
+
+    juce::Rectangle<int> mLoadMeterArea;
+   #endif
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     CoolChorusAudioProcessor& audioProcessor;
+
+    //By ID rather than by position, so adding a parameter never rewires the controls
+    RangedAudioParameter* findParameter(const String& parameterID) const;
     
     juce::Slider mDryWetSlider;
     juce::Slider mFeedbackSlider;
@@ -43,6 +59,13 @@ private:
     Slider mPhaseOffsetSlider;
     
     ComboBox mTypeBox;
+    ComboBox mWaveformBox;
+    ComboBox mVoicesBox;
+    ComboBox mInterpolationBox;
+    ComboBox mQualityBox;
+    ComboBox mOversamplingBox; //below the Feedback slider, whose resonances it tames
+    ComboBox mLFOSyncBox;      //below the Rate slider, which it replaces with the host's tempo
+    ComboBox mSyncRateBox;
     
     juce::Label mDryWetLabel;
     juce::Label mFeedbackLabel;
@@ -52,5 +75,29 @@ private:
     Label mPhaseOffsetLabel;
     Label mTypeLabel; 
 
+    //Keep the controls and the parameters in step both ways, so a program change, a restored state or host automation
+    //shows up in the editor. Declared after the controls so they are destroyed first
+    std::unique_ptr<SliderParameterAttachment> mDryWetAttachment;
+    std::unique_ptr<SliderParameterAttachment> mDepthAttachment;
+    std::unique_ptr<SliderParameterAttachment> mRateAttachment;
+    std::unique_ptr<SliderParameterAttachment> mPhaseOffsetAttachment;
+    std::unique_ptr<SliderParameterAttachment> mFeedbackAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mTypeAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mWaveformAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mVoicesAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mInterpolationAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mQualityAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mOversamplingAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mLFOSyncAttachment;
+    std::unique_ptr<ComboBoxParameterAttachment> mSyncRateAttachment;
+
+    static constexpr int optionsRowHeight = 25;
+
+   #if COOLCHORUS_SCOPE
+    //LFO, delay time and output level below the controls
+    static constexpr int scopeHeight = 90;
+    ScopeComponent mScope;
+   #endif
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoolChorusAudioProcessorEditor)
 };
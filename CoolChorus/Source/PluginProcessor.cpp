@@ -23,6 +23,8 @@ CoolChorusAudioProcessor::CoolChorusAudioProcessor()
 #endif
 {
     //initilization
+    mNumProcessedChannels = 0;
+
     addParameter(mDryWetParameter = new AudioParameterFloat("drywet",
                                                              "Dry Wet",
                                                              0.0,
@@ -53,32 +55,58 @@ CoolChorusAudioProcessor::CoolChorusAudioProcessor()
                                                          0,
                                                          1,
                                                          0));
-                                    
-    mCircularBufferLeft = nullptr;
-    mCircularBufferRight= nullptr;
-    mCircularBufferWriteHead = 0;
-    mCircularBufferLength = 0;
-    mDelayTimeInSamples = 0;
-    mDelayReadHead = 0;
-    mFeedbackLeft = 0;
-    mFeedbackRight = 0;
-    mDelayTimeSmoothed = 0;
-    
-    mLFOPhase = 0;
+    addParameter(mWaveformParameter = new AudioParameterChoice ("lfowaveform",
+                                                                "LFO Waveform",
+                                                                ChorusLFO::getWaveformNames(),
+                                                                ChorusLFO::sineWave));
+    addParameter(mVoicesParameter = new AudioParameterInt ("voices",
+                                                           "Voices",
+                                                           1,
+                                                           MAX_VOICES,
+                                                           1));
+    addParameter(mInterpolationParameter = new AudioParameterChoice ("interpolation",
+                                                                     "Interpolation",
+                                                                     Interpolation::getModeNames(),
+                                                                     Interpolation::linear));
+    //Quality picks the precision the chorus is prepared with and only takes effect in prepareToPlay. Oversampling switches at
+    //the next block but restarts the delay loop and changes the latency. The host is told not to automate either
+    addParameter(mQualityParameter = new AudioParameterChoice ("quality",
+                                                               "Quality",
+                                                               ChorusQuality::getModeNames(),
+                                                               ChorusQuality::automatic,
+                                                               AudioParameterChoiceAttributes().withAutomatable (false)));
+    addParameter(mOversamplingParameter = new AudioParameterChoice ("oversampling",
+                                                                    "Oversampling",
+                                                                    Oversampling::getModeNames(),
+                                                                    Oversampling::off,
+                                                                    AudioParameterChoiceAttributes().withAutomatable (false)));
+    addParameter(mLFOSyncParameter = new AudioParameterChoice ("lfosync",
+                                                               "LFO Sync",
+                                                               TempoSync::getModeNames(),
+                                                               TempoSync::free));
+    addParameter(mSyncRateParameter = new AudioParameterChoice ("syncrate",
+                                                                "Sync Rate",
+                                                                TempoSync::getDivisionNames(),
+                                                                TempoSync::quarterNoteDivision));
+
+    //The state keeps the parameters by their position in ChorusState, not in the list above
+    for (int i = 0; i < ChorusState::numParameters; ++i)
+    {
+        mStateParameters[i] = nullptr;
+
+        for (auto* parameter : getParameters())
+            if (auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter))
+                if (ranged->getParameterID() == ChorusState::parameterIDs[i])
+                    mStateParameters[i] = ranged;
+
+        jassert (mStateParameters[i] != nullptr);
+    }
 }
 
 CoolChorusAudioProcessor::~CoolChorusAudioProcessor()
 {
-    //Free memory once App Closes
-    if (mCircularBufferLeft != nullptr) {
-        delete [] mCircularBufferLeft;
-        mCircularBufferLeft = nullptr;
-    }
-    
-    if (mCircularBufferRight == nullptr) {
-        delete [] mCircularBufferRight;
-        mCircularBufferRight = nullptr;
-    }
+    //Delay memory is owned by the chorus processors and freed with them
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -116,69 +144,182 @@ bool CoolChorusAudioProcessor::isMidiEffect() const
 
 double CoolChorusAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    //The feedback loop keeps ringing after the input stops, up to several seconds near the top of the Feedback range
+    return getCurrentParameters().getTailLengthSeconds();
 }
 
 int CoolChorusAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return FactoryPresets::numPresets;
 }
 
 int CoolChorusAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return mCurrentProgram;
 }
 
 void CoolChorusAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow(index, FactoryPresets::numPresets))
+        return;
+
+    mCurrentProgram = index;
+
+    //Hosts call this from the message thread, or for a VST3 program change from the audio thread. Either way the values go
+    //straight into the parameters' atomics, the host and the editor are told from the message thread in handleAsyncUpdate
+    const FactoryPreset& preset = FactoryPresets::presets[index];
+
+    const auto setPlainValue = [] (RangedAudioParameter* parameter, float value)
+    {
+        parameter->setValue(parameter->convertTo0to1(value));
+    };
+
+    setPlainValue(mDryWetParameter, preset.dryWet);
+    setPlainValue(mDepthParameter, preset.depth);
+    setPlainValue(mRateParameter, preset.rate);
+    setPlainValue(mPhaseOffsetParameter, preset.phaseOffset);
+    setPlainValue(mFeedbackParameter, preset.feedback);
+    setPlainValue(mTypeParameter, (float) preset.type);
+    setPlainValue(mWaveformParameter, (float) preset.waveform);
+    setPlainValue(mVoicesParameter, (float) preset.numVoices);
+    setPlainValue(mInterpolationParameter, (float) preset.interpolation);
+
+    //Published last, the block that takes the flag reads all nine values. One that starts while they are being written
+    //smooths towards the ones it sees and the next block recalls
+    mRecallPending.store(true, std::memory_order_release);
+    mParametersChanged = true;
+
+    if (juce::MessageManager::existsAndIsCurrentThread())
+        handleAsyncUpdate();
+    else
+        triggerAsyncUpdate();
 }
 
 const juce::String CoolChorusAudioProcessor::getProgramName (int index)
 {
-    return {};
+    if (! juce::isPositiveAndBelow(index, FactoryPresets::numPresets))
+        return {};
+
+    return FactoryPresets::presets[index].name;
 }
 
 void CoolChorusAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    //The factory presets keep their names
 }
 
-//==============================================================================
-namespace myfunc
-{
-    float lin_interp ( float sample_x, float sample_x1, float inPhase)
-    { //InPhase == time
-        return (1 - inPhase) * sample_x + inPhase * sample_x1;
-    }
-}
 //==============================================================================
 void CoolChorusAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
-    mDelayTimeInSamples = 1;
-    mLFOPhase = 0;
-    
-    mCircularBufferLength = sampleRate * MAX_DELAY_TIME;
-    
-    //Determining Circ Buffer Length using Sample Rate
-    if (mCircularBufferLeft == nullptr)
+
+    //Every channel of the layout is chorused except the LFE, which passes through untouched
+    const juce::AudioChannelSet layout = getChannelLayoutOfBus(false, 0);
+    mNumProcessedChannels = 0;
+
+    for (int channel = 0; channel < juce::jmin(getTotalNumOutputChannels(), MAX_CHANNELS); ++channel)
     {
-        mCircularBufferLeft = new float[mCircularBufferLength];
+        const auto channelType = layout.getTypeOfChannel(channel);
+
+        if (channelType != juce::AudioChannelSet::LFE && channelType != juce::AudioChannelSet::LFE2)
+            mProcessedChannels[mNumProcessedChannels++] = channel;
     }
-    
-        
-    juce::zeromem(mCircularBufferLeft, mCircularBufferLength * sizeof(float));
-        
-    if (mCircularBufferRight == nullptr)
+
+    //The host picks the precision before preparing, only the chorus for it is kept, the double one for a float bus at the
+    //Render quality. It starts settled on the current parameters
+    const ChorusParameters initialParameters = getCurrentParameters();
+    const bool useDoubleChorus = isUsingDoublePrecision() || getQualityTier() == ChorusQuality::render;
+    const juce::dsp::ProcessSpec spec { sampleRate, (juce::uint32) juce::jmax(1, samplesPerBlock), (juce::uint32) juce::jmax(1, mNumProcessedChannels) };
+
+    //The chorus starts settled on the parameters, there is nothing left to recall. A synced LFO finds its place on the first block
+    mRecallPending = false;
+    mTransportSync.reset();
+
+    //Allocated for 4x whatever Oversampling is at, so processBlock can switch it without allocating
+    const int oversamplingFactor = Oversampling::getFactor(mOversamplingParameter->getIndex());
+    const int maxOversamplingFactor = Oversampling::getFactor(Oversampling::fourTimes);
+
+    if (useDoubleChorus)
     {
-        mCircularBufferRight = new float[mCircularBufferLength];
+        if (mDoubleChorus == nullptr)
+            mDoubleChorus = std::make_unique<ChorusProcessor<double>>();
+
+        mDoubleChorus->setParameters(initialParameters);
+        mDoubleChorus->setOversamplingFactor(oversamplingFactor);
+        mDoubleChorus->setMaxOversamplingFactor(maxOversamplingFactor);
+        mDoubleChorus->prepare(spec);
+        mFloatChorus.reset();
+        mChorusLatency = mDoubleChorus->getLatencyInSamples();
+    }
+    else
+    {
+        if (mFloatChorus == nullptr)
+            mFloatChorus = std::make_unique<ChorusProcessor<float>>();
+
+        mFloatChorus->setParameters(initialParameters);
+        mFloatChorus->setOversamplingFactor(oversamplingFactor);
+        mFloatChorus->setMaxOversamplingFactor(maxOversamplingFactor);
+        mFloatChorus->prepare(spec);
+        mDoubleChorus.reset();
+        mChorusLatency = mFloatChorus->getLatencyInSamples();
+    }
+
+    //the host reads the latency once this returns
+    setLatencySamples(mChorusLatency);
+
+    //A float bus goes through the double chorus a prepared block at a time
+    if (useDoubleChorus && ! isUsingDoublePrecision())
+        mConversionBuffer.setSize(mNumProcessedChannels, juce::jmax(1, samplesPerBlock));
+    else
+        mConversionBuffer.setSize(0, 0);
+
+    if (mLFOPhasePending.exchange(false))
+    {
+        if (mFloatChorus != nullptr)
+            mFloatChorus->setLFOPhase(mRestoredLFOPhase);
+
+        if (mDoubleChorus != nullptr)
+            mDoubleChorus->setLFOPhase(mRestoredLFOPhase);
     }
-    
-    juce::zeromem(mCircularBufferRight, mCircularBufferLength * sizeof(float));
 
-    mCircularBufferWriteHead = 0;
-    
+   #if COOLCHORUS_SCOPE
+    if (mFloatChorus != nullptr)
+        mFloatChorus->setScopeFeed(&mScopeFeed);
+
+    if (mDoubleChorus != nullptr)
+        mDoubleChorus->setScopeFeed(&mScopeFeed);
+   #endif
+}
+
+void CoolChorusAudioProcessor::handleAsyncUpdate()
+{
+    //A program change sets the values without telling anyone, the same values are sent again to the host and the editor
+    if (mParametersChanged.exchange(false))
+    {
+        for (auto* parameter : mStateParameters)
+            parameter->setValueNotifyingHost(parameter->getValue());
+
+        updateHostDisplay(ChangeDetails().withProgramChanged(true));
+    }
+
+    //setLatencySamples tells the host with updateHostDisplay (ChangeDetails().withLatencyChanged (true)) when the value moved,
+    //the host then asks for the latency and usually prepares again
+    setLatencySamples(mChorusLatency);
+}
+
+size_t CoolChorusAudioProcessor::getMemoryFootprint() const
+{
+    size_t bytes = sizeof(*this);
+
+    if (mFloatChorus != nullptr)
+        bytes += sizeof(*mFloatChorus) + mFloatChorus->getAllocatedBytes();
+
+    if (mDoubleChorus != nullptr)
+        bytes += sizeof(*mDoubleChorus) + mDoubleChorus->getAllocatedBytes();
+
+    bytes += (size_t) mConversionBuffer.getNumChannels() * (size_t) mConversionBuffer.getNumSamples() * sizeof(double);
+    return bytes;
 }
 
 void CoolChorusAudioProcessor::releaseResources()
@@ -194,12 +335,12 @@ bool CoolChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Mono, stereo and the surround and immersive layouts up to MAX_CHANNELS,
+    // e.g. LCR, 5.1, 7.1 and 7.1.4, the engine processes any channel count.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const juce::AudioChannelSet& output = layouts.getMainOutputChannelSet();
+    if (output.isDisabled() || output.size() > MAX_CHANNELS)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -213,8 +354,60 @@ bool CoolChorusAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
 }
 #endif
 
+bool CoolChorusAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+//Snapshot parameters once per block, the chorus never touches the atomics
+ChorusParameters CoolChorusAudioProcessor::getCurrentParameters() const
+{
+    ChorusParameters parameters;
+    parameters.dryWet = *mDryWetParameter;
+    parameters.depth = *mDepthParameter;
+    parameters.rate = *mRateParameter;
+    parameters.phaseOffset = *mPhaseOffsetParameter;
+    parameters.feedback = *mFeedbackParameter;
+    parameters.type = mTypeParameter->get();
+    parameters.waveform = mWaveformParameter->getIndex();
+    parameters.numVoices = mVoicesParameter->get();
+    parameters.interpolation = ChorusQuality::getInterpolation(getQualityTier(), mInterpolationParameter->getIndex());
+    return parameters;
+}
+
+int CoolChorusAudioProcessor::getQualityTier() const
+{
+    return ChorusQuality::resolve(mQualityParameter->getIndex(), isNonRealtime());
+}
+
 void CoolChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    //prepared at the Render quality, see prepareToPlay
+    if (mDoubleChorus != nullptr)
+        processWithChorus(buffer, mDoubleChorus.get());
+    else
+        processWithChorus(buffer, mFloatChorus.get());
+}
+
+//A 64 bit host bus is processed as it is, with no conversion to float and back
+void CoolChorusAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processWithChorus(buffer, mDoubleChorus.get());
+}
+
+template <typename SampleType, typename ChorusSampleType>
+void CoolChorusAudioProcessor::processWithChorus (juce::AudioBuffer<SampleType>& buffer, ChorusProcessor<ChorusSampleType>* chorus)
+{
+   #if COOLCHORUS_REALTIME_GUARD
+    const RealtimeGuard::ScopedRealtimeSection realtimeSection;
+   #endif
+
+   #if COOLCHORUS_TELEMETRY
+    const ProcessTelemetry::ScopedBlockTimer blockTimer (mTelemetry, buffer.getNumSamples(), getSampleRate());
+   #endif
+
+    COOLCHORUS_TRACE_ZONE ("processBlock");
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -223,68 +416,97 @@ void CoolChorusAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    //the chorus for this precision only exists once prepareToPlay has run with it
+    jassert (chorus != nullptr);
+    const int numSamples = buffer.getNumSamples();
+    if (numSamples == 0 || chorus == nullptr || mNumProcessedChannels == 0)
+        return;
+
+    //The channels the chorus was prepared with, in bus order with the LFE left out
+    SampleType* channels[MAX_CHANNELS];
+    for (int i = 0; i < mNumProcessedChannels; ++i)
+        channels[i] = buffer.getWritePointer(mProcessedChannels[i]);
+
+    //Taken before the parameters are read, so a preset's values published with the flag are all seen
+    const bool recallPending = mRecallPending.exchange(false, std::memory_order_acquire);
+    ChorusParameters parameters = getCurrentParameters();
+
+    //Tempo sync: the rate from the host's tempo and, while the transport runs, the LFO's place from the song position,
+    //both read once per block
+    TransportSync::Position position;
+
+    if (mLFOSyncParameter->getIndex() == TempoSync::tempo)
+    {
+        position = mTransportSync.update(getPlayHead(), mSyncRateParameter->getIndex(), getSampleRate(), numSamples);
+
+        if (position.hasTempo)
+            parameters.rate = position.rate;
+    }
+    else
+    {
+        mTransportSync.reset();
+    }
+
+    //A preset or a restored state is recalled with a crossfade, everything else is smoothed
+    if (recallPending)
+        chorus->recall(parameters);
+    else
+        chorus->setParameters(parameters);
 
-    float* leftChannel = buffer.getWritePointer(0);
-    float* rightChannel = buffer.getWritePointer(1);
+    if (mLFOPhasePending.exchange(false))
+        chorus->setLFOPhase(mRestoredLFOPhase);
 
-    for ( int i =0; i < buffer.getNumSamples(); i++ ) {
-        
-        float lfoOut = sin(2*M_PI * mLFOPhase);
-        mLFOPhase += *mRateParameter / getSampleRate(); //frequency/sr
-        
-        if (mLFOPhase > 1)
+    if (position.isPlaying)
+        chorus->syncLFO(position.cycles, position.isJump);
+
+    //the chorus switches at the start of its next process(), with a fresh delay loop
+    chorus->setOversamplingFactor(Oversampling::getFactor(mOversamplingParameter->getIndex()));
+
+    if constexpr (std::is_same<SampleType, ChorusSampleType>::value)
+    {
+        //a view of the bus' own channels, processed in place
+        juce::dsp::AudioBlock<SampleType> block (channels, (size_t) mNumProcessedChannels, (size_t) numSamples);
+        chorus->process(juce::dsp::ProcessContextReplacing<SampleType> (block));
+    }
+    else
+    {
+        //A float bus in the double chorus, converted in pieces no longer than the buffer prepareToPlay sized
+        ChorusSampleType* converted[MAX_CHANNELS];
+        for (int i = 0; i < mNumProcessedChannels; ++i)
+            converted[i] = mConversionBuffer.getWritePointer(i);
+
+        const int maxChunkSize = mConversionBuffer.getNumSamples();
+        jassert (maxChunkSize > 0);
+
+        for (int start = 0; start < numSamples && maxChunkSize > 0; start += maxChunkSize)
         {
-            mLFOPhase -= 1;
-        }
-        
-        
-        lfoOut *= *mDepthParameter;
-        float lfoOutMapped = jmap(lfoOut, -1.f, 1.f, 0.005f, 0.03f);
-        
-        
-        mDelayTimeSmoothed = mDelayTimeSmoothed - 0.001 * (mDelayTimeSmoothed - lfoOutMapped); //smoothing helps when lfo is using a saw tooth or other types of waveforms to prevents clicks. (Previously 0.0001)
-        
-        //(mDelayTimeSmoothed - *mDelayTimeParameter); //Smoothing Formula
-        
-        mDelayTimeInSamples = getSampleRate() * mDelayTimeSmoothed;
-
-        mCircularBufferLeft[mCircularBufferWriteHead] = leftChannel[i] + mFeedbackLeft;
-        mCircularBufferRight[mCircularBufferWriteHead]= rightChannel[i] + mFeedbackRight;
-        
-        //Setting delay readhead
-        mDelayReadHead = mCircularBufferWriteHead - mDelayTimeInSamples;
-        if ( mDelayReadHead < 0 ) {
-            mDelayReadHead += mCircularBufferLength;
-        }
-        
-        int readHead_x = (int)mDelayReadHead;
-        int readHead_x1 = readHead_x + 1;
-        if ( readHead_x1 >= mCircularBufferLength) { //checking to see if readHead is wrapping around
-            readHead_x1 -= mCircularBufferLength;
-        }
-        float readHeadFloat = mDelayReadHead - readHead_x; //the difference between the two readheads
-        
-        
-        
-        float delay_sample_left = myfunc::lin_interp(mCircularBufferLeft[readHead_x], mCircularBufferLeft[readHead_x1], readHeadFloat);
-        float delay_sample_right = myfunc::lin_interp(mCircularBufferRight[readHead_x], mCircularBufferRight[readHead_x1], readHeadFloat);
-        
-        mFeedbackLeft = delay_sample_left * *mFeedbackParameter;
-        mFeedbackRight = delay_sample_right * *mFeedbackParameter;
-
-        //adding the delayed signal to the dry signal
-        buffer.setSample( 0, i, buffer.getSample(0, i) * (1 - *mDryWetParameter) + delay_sample_left * *mDryWetParameter );
-        buffer.setSample( 1, i, buffer.getSample(1, i) * (1 - *mDryWetParameter)+ delay_sample_right * *mDryWetParameter );
-
-        //Wrapping around ReadHead is index is less than zero
-
-        mCircularBufferWriteHead++;
-        
-        
-        if ( mCircularBufferWriteHead >= mCircularBufferLength) {
-            mCircularBufferWriteHead = 0;
+            const int chunkSize = juce::jmin(maxChunkSize, numSamples - start);
+
+            for (int i = 0; i < mNumProcessedChannels; ++i)
+                for (int n = 0; n < chunkSize; ++n)
+                    converted[i][n] = (ChorusSampleType) channels[i][start + n];
+
+            juce::dsp::AudioBlock<ChorusSampleType> block (converted, (size_t) mNumProcessedChannels, (size_t) chunkSize);
+            chorus->process(juce::dsp::ProcessContextReplacing<ChorusSampleType> (block));
+
+            for (int i = 0; i < mNumProcessedChannels; ++i)
+                for (int n = 0; n < chunkSize; ++n)
+                    channels[i][start + n] = (SampleType) converted[i][n];
         }
     }
+
+    mLFOPhase = chorus->getLFOPhase();
+
+    //A new factor brings a new latency, only the message thread may tell the host
+    const int latency = chorus->getLatencyInSamples();
+    if (mChorusLatency.exchange(latency) != latency)
+        triggerAsyncUpdate();
+
+   #if COOLCHORUS_SCOPE
+    //Output level across the processed channels, only while the editor's scope is open
+    if (mScopeFeed.isActive())
+        mScopeFeed.pushLevels(ScopeFeed::measure(channels, mNumProcessedChannels, numSamples));
+   #endif
 }
 
 //==============================================================================
@@ -301,15 +523,81 @@ juce::AudioProcessorEditor* CoolChorusAudioProcessor::createEditor()
 //==============================================================================
 void CoolChorusAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    //A fixed layout of a few dozen bytes, a session of hundreds of instances loads without parsing any text
+    ChorusState state;
+
+    for (int i = 0; i < ChorusState::numParameters; ++i)
+        state.values[i] = mStateParameters[i]->getValue();
+
+    state.lfoPhase = mLFOPhase;
+    state.program = mCurrentProgram;
+    state.writeTo(destData);
 }
 
 void CoolChorusAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    ChorusState state;
+
+    if (state.readFrom(data, sizeInBytes))
+    {
+        restoreState(state);
+    }
+    else if (const std::unique_ptr<juce::XmlElement> xml = getXmlFromBinary(data, sizeInBytes))
+    {
+        if (xml->hasTagName("PRESET"))
+            restoreStateFromXml(*xml);
+    }
+}
+
+std::unique_ptr<juce::XmlElement> CoolChorusAudioProcessor::createStateXml() const
+{
+    auto xml = std::make_unique<juce::XmlElement>("PRESET");
+    xml->setAttribute("version", ChorusState::currentVersion);
+    xml->setAttribute("program", mCurrentProgram.load());
+    xml->setAttribute("lfophase", (double) mLFOPhase.load());
+
+    for (int i = 0; i < ChorusState::numParameters; ++i)
+    {
+        auto* param = xml->createNewChildElement("PARAM");
+        param->setAttribute("id", ChorusState::parameterIDs[i]);
+        param->setAttribute("value", mStateParameters[i]->getCurrentValueAsText());
+    }
+
+    return xml;
+}
+
+void CoolChorusAudioProcessor::restoreState (const ChorusState& state)
+{
+    for (int i = 0; i < ChorusState::numParameters; ++i)
+        mStateParameters[i]->setValueNotifyingHost(i < state.numValues ? state.values[i] : mStateParameters[i]->getDefaultValue());
+
+    //Published after the values, as for a program change
+    mRecallPending.store(true, std::memory_order_release);
+
+    mCurrentProgram = juce::jlimit(0, FactoryPresets::numPresets - 1, state.program);
+    mRestoredLFOPhase = state.lfoPhase;
+    mLFOPhasePending = true;
+}
+
+void CoolChorusAudioProcessor::restoreStateFromXml (const juce::XmlElement& xml)
+{
+    //Values are read as a user would type them, parameters that are missing or unknown keep to their defaults
+    ChorusState state;
+
+    for (int i = 0; i < ChorusState::numParameters; ++i)
+        state.values[i] = mStateParameters[i]->getDefaultValue();
+
+    for (auto* param : xml.getChildWithTagNameIterator("PARAM"))
+    {
+        const int index = ChorusState::indexOf(param->getStringAttribute("id"));
+
+        if (index >= 0)
+            state.values[index] = mStateParameters[index]->getValueForText(param->getStringAttribute("value"));
+    }
+
+    state.lfoPhase = (float) xml.getDoubleAttribute("lfophase");
+    state.program = xml.getIntAttribute("program");
+    restoreState(state);
 }
 
 //==============================================================================
@@ -9,15 +9,20 @@
 #pragma once
 
 #include <JuceHeader.h>
-
-#define MAX_DELAY_TIME 2
+#include "ChorusProcessor.h"
+#include "ChorusState.h"
+#include "FactoryPresets.h"
+#include "TempoSync.h"
+#include "ProcessTelemetry.h"
+#include "RealtimeGuard.h"
 
 //==============================================================================
 /**
 */
 using namespace juce;
 
-class CoolChorusAudioProcessor  : public juce::AudioProcessor
+class CoolChorusAudioProcessor  : public juce::AudioProcessor,
+                                  private juce::AsyncUpdater
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
@@ -36,6 +41,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -50,24 +57,74 @@ public:
     double getTailLengthSeconds() const override;
 
     //==============================================================================
+    //The programs are the factory presets. Switching to one only writes the parameters' values, so hosts may do it from the
+    //audio thread. The chorus crossfades to it on the next block and the host hears of the values from the message thread
     int getNumPrograms() override;
     int getCurrentProgram() override;
     void setCurrentProgram (int index) override;
     const juce::String getProgramName (int index) override;
     void changeProgramName (int index, const juce::String& newName) override;
 
+    //Bytes one instance holds, the object itself plus the chorus prepared for the current precision and sample rate
+    size_t getMemoryFootprint() const;
+
+   #if COOLCHORUS_TELEMETRY
+    //Timing of every processBlock, for the editor's load meter and for monitoring. Message thread only
+    ProcessTelemetry& getTelemetry() noexcept { return mTelemetry; }
+   #endif
+
+   #if COOLCHORUS_SCOPE
+    //LFO, delay time and output level for the editor's scope, read on the message thread
+    ScopeFeed& getScopeFeed() noexcept { return mScopeFeed; }
+   #endif
+
     //==============================================================================
+    //The state is a ChorusState block. setStateInformation also takes the XML of createStateXml stored with copyXmlToBinary
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    float lin_interp ( float sample_x, float sample_x1, float inPhase);
+
+    //The state as a <PRESET> of the parameters' text, e.g. "Triangle" for LFO Waveform, for people to read and edit.
+    //The CLI reads it with --params
+    std::unique_ptr<juce::XmlElement> createStateXml() const;
 
 private:
     //==============================================================================
-    
-    float mDelayTimeSmoothed;
-    float mLFOPhase;
-    
+    ChorusParameters getCurrentParameters() const;
+
+    //Tells the host and the editor of a program change and reports a latency the audio thread found changed, an Oversampling
+    //switch, to the host
+    void handleAsyncUpdate() override;
+
+    //The ChorusQuality tier the Quality parameter resolves to right now
+    int getQualityTier() const;
+
+    //Sets every parameter from state, the ones it does not have to their defaults, and has the chorus crossfade to them
+    void restoreState (const ChorusState& state);
+    void restoreStateFromXml (const juce::XmlElement& xml);
+
+    template <typename SampleType, typename ChorusSampleType>
+    void processWithChorus (juce::AudioBuffer<SampleType>& buffer, ChorusProcessor<ChorusSampleType>* chorus);
+
+    //The DSP, the plugin only maps its bus and parameters onto it. Only one exists, for the host's processing precision or the
+    //double one when a float bus is prepared at the Render quality
+    std::unique_ptr<ChorusProcessor<float>> mFloatChorus;
+    std::unique_ptr<ChorusProcessor<double>> mDoubleChorus;
+
+    //The processed channels of a float bus in double, for the double chorus at the Render quality. Empty otherwise
+    juce::AudioBuffer<double> mConversionBuffer;
+
+    //Bus channels the chorus processes, set from the layout in prepareToPlay
+    int mProcessedChannels[MAX_CHANNELS];
+    int mNumProcessedChannels;
+
+   #if COOLCHORUS_TELEMETRY
+    ProcessTelemetry mTelemetry;
+   #endif
+
+   #if COOLCHORUS_SCOPE
+    ScopeFeed mScopeFeed;
+   #endif
+
     AudioParameterFloat* mDryWetParameter;
     AudioParameterFloat* mFeedbackParameter;
     //juce::AudioParameterFloat* mDelayTimeParameter; This will be modulated by our LFO
@@ -76,18 +133,36 @@ private:
     AudioParameterFloat* mPhaseOffsetParameter;
     
     AudioParameterInt* mTypeParameter;
-    
-    float* mCircularBufferLeft;
-    float* mCircularBufferRight;
-    
-    int mCircularBufferWriteHead;
-    int mCircularBufferLength;
-    
-    float mDelayTimeInSamples;
-    float mDelayReadHead;
-    
-    float mFeedbackLeft;
-    float mFeedbackRight;
+    AudioParameterChoice* mWaveformParameter;
+    AudioParameterInt* mVoicesParameter;
+    AudioParameterChoice* mInterpolationParameter;
+    AudioParameterChoice* mQualityParameter;
+    AudioParameterChoice* mOversamplingParameter;
+    AudioParameterChoice* mLFOSyncParameter;
+    AudioParameterChoice* mSyncRateParameter;
+
+    //The host's position for a tempo synced LFO, audio thread only
+    TransportSync mTransportSync;
+
+    //The chorus' latency as of the last block, setLatencySamples() follows it on the message thread
+    std::atomic<int> mChorusLatency { 0 };
+
+    //The parameters in the order of ChorusState::parameterIDs
+    RangedAudioParameter* mStateParameters[ChorusState::numParameters];
+
+    //The factory preset last recalled
+    std::atomic<int> mCurrentProgram { 0 };
+
+    //Set when the parameters jumped to a preset or a restored state, the next block recalls them instead of smoothing
+    std::atomic<bool> mRecallPending { false };
+
+    //Set by a program change for handleAsyncUpdate to notify the host of the new values
+    std::atomic<bool> mParametersChanged { false };
+
+    //The LFO's phase after the last block, and a restored one waiting for the next block or prepareToPlay
+    std::atomic<float> mLFOPhase { 0.f };
+    std::atomic<float> mRestoredLFOPhase { 0.f };
+    std::atomic<bool> mLFOPhasePending { false };
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoolChorusAudioProcessor)
 };
@@ -0,0 +1,189 @@
+/*
+  ==============================================================================
+
+    ProcessTelemetry.h
+
+    Per block timing of processBlock, passed from the audio thread to the
+    message thread without locks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Compiles the block timing, its ring and the editor's load meter in or out
+#ifndef COOLCHORUS_TELEMETRY
+ #define COOLCHORUS_TELEMETRY 1
+#endif
+
+#if COOLCHORUS_TELEMETRY
+
+//==============================================================================
+/** What the message thread has gathered so far. Load is the time a block took as a percentage of its deadline, numSamples / sampleRate. */
+struct TelemetrySnapshot
+{
+    static constexpr int numLoadBins = 21;  //5% wide, the last one collects every block over its deadline
+    static constexpr int numTimeBins = 16;  //doubling from 1 us, the last one open ended
+
+    juce::int64 numBlocks = 0;
+    juce::int64 numDropped = 0;             //blocks the ring had no room for, they are in no other figure
+    juce::int64 numOverruns = 0;            //blocks that took longer than their deadline
+
+    double meanLoad = 0;                    //over every block since reset()
+    double worstLoad = 0;
+    double worstBlockMicroseconds = 0;
+
+    double recentLoad = 0;                  //over the blocks the last update() read
+    double recentPeakLoad = 0;
+
+    std::array<juce::int64, numLoadBins> loadHistogram {};
+    std::array<juce::int64, numTimeBins> timeHistogram {};
+
+    static int getLoadBin (double load) noexcept              { return juce::jlimit (0, numLoadBins - 1, (int) (load / 5.0)); }
+    static int getTimeBin (double microseconds) noexcept      { return microseconds < 1.0 ? 0 : juce::jmin (numTimeBins - 1, (int) std::floor (std::log2 (microseconds)) + 1); }
+
+    //Lower edge of a time bin in microseconds, the first bin starts at 0
+    static double getTimeBinStart (int bin) noexcept          { return bin == 0 ? 0.0 : std::exp2 ((double) (bin - 1)); }
+};
+
+//==============================================================================
+/**
+    Times every processBlock into a histogram.
+
+    The audio thread writes one record per block into a lock free ring and
+    counts the block as dropped when the ring is full. update(), reset() and
+    getSnapshot() belong to a single caller on the message thread. Compiled
+    out with COOLCHORUS_TELEMETRY=0.
+*/
+class ProcessTelemetry
+{
+public:
+    ProcessTelemetry()
+        : mFifo (capacity)
+    {
+    }
+
+    //==============================================================================
+    //Audio thread: times one block from construction to destruction
+    class ScopedBlockTimer
+    {
+    public:
+        ScopedBlockTimer (ProcessTelemetry& telemetry, int numSamples, double sampleRate) noexcept
+            : mTelemetry (telemetry), mNumSamples (numSamples), mSampleRate (sampleRate),
+              mStartTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedBlockTimer() noexcept
+        {
+            mTelemetry.push (juce::Time::getHighResolutionTicks() - mStartTicks, mNumSamples, mSampleRate);
+        }
+
+    private:
+        ProcessTelemetry& mTelemetry;
+        const int mNumSamples;
+        const double mSampleRate;
+        const juce::int64 mStartTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlockTimer)
+    };
+
+    //==============================================================================
+    //Message thread: reads every record the audio thread has written since the last call
+    void update()
+    {
+        int start1, size1, start2, size2;
+        mFifo.prepareToRead (mFifo.getNumReady(), start1, size1, start2, size2);
+
+        double recentLoadSum = 0;
+        mSnapshot.recentPeakLoad = 0;
+
+        for (int i = 0; i < size1 + size2; ++i)
+            recentLoadSum += addRecord (mRecords[(size_t) (i < size1 ? start1 + i : start2 + i - size1)]);
+
+        mFifo.finishedRead (size1 + size2);
+
+        mSnapshot.recentLoad = (size1 + size2 > 0) ? recentLoadSum / (size1 + size2) : 0.0;
+        mSnapshot.numDropped = mDropped.load (std::memory_order_relaxed) - mDroppedAtReset;
+    }
+
+    //Message thread: starts the figures again, the records still in the ring are discarded
+    void reset()
+    {
+        mFifo.finishedRead (mFifo.getNumReady());
+        mDroppedAtReset = mDropped.load (std::memory_order_relaxed);
+        mSnapshot = {};
+        mLoadSum = 0;
+    }
+
+    //Message thread: the figures as of the last update()
+    const TelemetrySnapshot& getSnapshot() const noexcept { return mSnapshot; }
+
+private:
+    //==============================================================================
+    struct BlockRecord
+    {
+        juce::int64 ticks;
+        int numSamples;
+        double sampleRate;
+    };
+
+    void push (juce::int64 ticks, int numSamples, double sampleRate) noexcept
+    {
+        int start1, size1, start2, size2;
+        mFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+        {
+            mDropped.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        mRecords[(size_t) (size1 > 0 ? start1 : start2)] = { ticks, numSamples, sampleRate };
+        mFifo.finishedWrite (1);
+    }
+
+    //Returns the block's load
+    double addRecord (const BlockRecord& record)
+    {
+        if (record.numSamples <= 0 || record.sampleRate <= 0)
+            return 0;
+
+        const double microseconds = juce::Time::highResolutionTicksToSeconds (record.ticks) * 1.0e6;
+        const double deadlineMicroseconds = record.numSamples * 1.0e6 / record.sampleRate;
+        const double load = 100.0 * microseconds / deadlineMicroseconds;
+
+        mSnapshot.numBlocks++;
+        mLoadSum += load;
+        mSnapshot.meanLoad = mLoadSum / (double) mSnapshot.numBlocks;
+
+        mSnapshot.worstLoad = juce::jmax (mSnapshot.worstLoad, load);
+        mSnapshot.worstBlockMicroseconds = juce::jmax (mSnapshot.worstBlockMicroseconds, microseconds);
+        mSnapshot.recentPeakLoad = juce::jmax (mSnapshot.recentPeakLoad, load);
+
+        if (load > 100.0)
+            mSnapshot.numOverruns++;
+
+        mSnapshot.loadHistogram[(size_t) TelemetrySnapshot::getLoadBin (load)]++;
+        mSnapshot.timeHistogram[(size_t) TelemetrySnapshot::getTimeBin (microseconds)]++;
+        return load;
+    }
+
+    //==============================================================================
+    static constexpr int capacity = 1024; //over a second of 64 sample blocks at 48 kHz between two updates
+
+    juce::AbstractFifo mFifo;
+    std::array<BlockRecord, capacity> mRecords;
+    std::atomic<juce::int64> mDropped { 0 };
+
+    //message thread only
+    TelemetrySnapshot mSnapshot;
+    double mLoadSum = 0;
+    juce::int64 mDroppedAtReset = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ProcessTelemetry)
+};
+
+#endif
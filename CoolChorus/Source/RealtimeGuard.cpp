@@ -0,0 +1,286 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.cpp
+
+    The replacement allocator and blocking calls behind RealtimeGuard.h.
+
+  ==============================================================================
+*/
+
+#include "RealtimeGuard.h"
+
+#if COOLCHORUS_REALTIME_GUARD
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <dlfcn.h>
+ #include <execinfo.h>
+ #include <pthread.h>
+ #include <time.h>
+ #define COOLCHORUS_GUARD_BACKTRACE 1
+#else
+ #define COOLCHORUS_GUARD_BACKTRACE 0
+#endif
+
+namespace
+{
+    constexpr int maxReports = 64;
+    constexpr int maxFrames = 24;
+
+    struct Report
+    {
+        RealtimeGuard::Violation kind;
+        size_t bytes;
+        int numFrames;
+        void* frames[maxFrames];
+    };
+
+    thread_local int realtimeDepth = 0;
+    thread_local bool reporting = false;    //the guard's own calls while it records one, never reported
+
+    std::atomic<bool> failFast { false };
+    std::atomic<int> numViolations { 0 };
+    Report reports[maxReports];
+
+    //backtrace() loads libgcc on its first call, which allocates, so that happens here rather than on the audio thread
+    struct BacktraceWarmUp
+    {
+        BacktraceWarmUp()
+        {
+           #if COOLCHORUS_GUARD_BACKTRACE
+            void* frame;
+            backtrace (&frame, 1);
+           #endif
+        }
+    } backtraceWarmUp;
+}
+
+//==============================================================================
+RealtimeGuard::ScopedRealtimeSection::ScopedRealtimeSection() noexcept    { ++realtimeDepth; }
+RealtimeGuard::ScopedRealtimeSection::~ScopedRealtimeSection() noexcept   { --realtimeDepth; }
+
+bool RealtimeGuard::isInRealtimeSection() noexcept
+{
+    return realtimeDepth > 0;
+}
+
+void RealtimeGuard::setFailFast (bool shouldFailFast) noexcept
+{
+    failFast = shouldFailFast;
+}
+
+void RealtimeGuard::reportViolation (Violation kind, size_t bytes) noexcept
+{
+    if (realtimeDepth == 0 || reporting)
+        return;
+
+    reporting = true;
+
+    if (failFast)
+    {
+        std::fprintf (stderr, "RealtimeGuard: %s on the audio thread\n", getViolationName (kind));
+        std::abort();
+    }
+
+    const int index = numViolations.fetch_add (1);
+
+    if (index < maxReports)
+    {
+        auto& report = reports[index];
+        report.kind = kind;
+        report.bytes = bytes;
+       #if COOLCHORUS_GUARD_BACKTRACE
+        report.numFrames = backtrace (report.frames, maxFrames);
+       #else
+        report.numFrames = 0;
+       #endif
+    }
+
+    reporting = false;
+}
+
+int RealtimeGuard::getNumViolations() noexcept
+{
+    return numViolations.load();
+}
+
+juce::StringArray RealtimeGuard::getReports()
+{
+    jassert (! isInRealtimeSection());
+
+    juce::StringArray result;
+    const int numViolationsNow = getNumViolations();
+
+    for (int i = 0; i < juce::jmin (numViolationsNow, maxReports); ++i)
+    {
+        const auto& report = reports[i];
+        juce::String text = getViolationName (report.kind);
+
+        if (report.kind == allocation)
+            text << " of " << juce::String ((int) report.bytes) << " bytes";
+
+       #if COOLCHORUS_GUARD_BACKTRACE
+        //frame 0 is reportViolation itself, the replaced function and then its caller follow
+        if (char** symbols = backtrace_symbols (report.frames, report.numFrames))
+        {
+            for (int frame = 1; frame < report.numFrames; ++frame)
+                text << "\n    " << symbols[frame];
+
+            std::free (symbols);
+        }
+       #endif
+
+        result.add (text);
+    }
+
+    if (numViolationsNow > maxReports)
+        result.add (juce::String (numViolationsNow - maxReports) + " more without a call stack");
+
+    return result;
+}
+
+void RealtimeGuard::clearReports() noexcept
+{
+    numViolations = 0;
+}
+
+//==============================================================================
+#if defined (__GLIBC__)
+
+//glibc exports its allocator under these names too, the replacements forward to them
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)
+    {
+        RealtimeGuard::reportViolation (RealtimeGuard::allocation, size);
+        return __libc_malloc (size);
+    }
+
+    void* calloc (size_t count, size_t size)
+    {
+        RealtimeGuard::reportViolation (RealtimeGuard::allocation, count * size);
+        return __libc_calloc (count, size);
+    }
+
+    void* realloc (void* pointer, size_t size)
+    {
+        RealtimeGuard::reportViolation (RealtimeGuard::allocation, size);
+        return __libc_realloc (pointer, size);
+    }
+
+    void* aligned_alloc (size_t alignment, size_t size)
+    {
+        RealtimeGuard::reportViolation (RealtimeGuard::allocation, size);
+        return __libc_memalign (alignment, size);
+    }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        RealtimeGuard::reportViolation (RealtimeGuard::allocation, size);
+
+        if (alignment < sizeof (void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr ? 0 : ENOMEM;
+    }
+
+    void free (void* pointer)
+    {
+        if (pointer != nullptr)
+            RealtimeGuard::reportViolation (RealtimeGuard::deallocation, 0);
+
+        __libc_free (pointer);
+    }
+}
+
+#else
+
+//operator new and delete are the only part of the allocator that can be replaced portably
+void* operator new (std::size_t size)
+{
+    RealtimeGuard::reportViolation (RealtimeGuard::allocation, size);
+
+    if (void* pointer = std::malloc (size > 0 ? size : 1))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                                     { return operator new (size); }
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept       { try { return operator new (size); } catch (...) { return nullptr; } }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept     { return operator new (size, std::nothrow); }
+
+void operator delete (void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        RealtimeGuard::reportViolation (RealtimeGuard::deallocation, 0);
+
+    std::free (pointer);
+}
+
+void operator delete[] (void* pointer) noexcept                             { operator delete (pointer); }
+void operator delete (void* pointer, std::size_t) noexcept                  { operator delete (pointer); }
+void operator delete[] (void* pointer, std::size_t) noexcept                { operator delete (pointer); }
+
+#endif
+
+//==============================================================================
+#if JUCE_LINUX
+
+//Resolved on first use, by then the dynamic linker no longer needs these itself
+template <typename Function>
+static Function findNext (Function& cached, const char* name) noexcept
+{
+    if (cached == nullptr)
+        cached = reinterpret_cast<Function> (dlsym (RTLD_NEXT, name));
+
+    return cached;
+}
+
+extern "C"
+{
+    int pthread_mutex_lock (pthread_mutex_t* mutex)
+    {
+        static int (*next) (pthread_mutex_t*) = nullptr;
+        RealtimeGuard::reportViolation (RealtimeGuard::lock, 0);
+        return findNext (next, "pthread_mutex_lock") (mutex);
+    }
+
+    int pthread_cond_wait (pthread_cond_t* condition, pthread_mutex_t* mutex)
+    {
+        static int (*next) (pthread_cond_t*, pthread_mutex_t*) = nullptr;
+        RealtimeGuard::reportViolation (RealtimeGuard::wait, 0);
+        return findNext (next, "pthread_cond_wait") (condition, mutex);
+    }
+
+    int pthread_cond_timedwait (pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        static int (*next) (pthread_cond_t*, pthread_mutex_t*, const struct timespec*) = nullptr;
+        RealtimeGuard::reportViolation (RealtimeGuard::wait, 0);
+        return findNext (next, "pthread_cond_timedwait") (condition, mutex, time);
+    }
+
+    int nanosleep (const struct timespec* duration, struct timespec* remaining)
+    {
+        static int (*next) (const struct timespec*, struct timespec*) = nullptr;
+        RealtimeGuard::reportViolation (RealtimeGuard::sleep, 0);
+        return findNext (next, "nanosleep") (duration, remaining);
+    }
+}
+
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    RealtimeGuard.h
+
+    Debug mode that flags allocations, locks and sleeps made on the audio
+    thread while processBlock runs.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Interposes the allocator and the blocking calls, for debug and test builds only
+#ifndef COOLCHORUS_REALTIME_GUARD
+ #define COOLCHORUS_REALTIME_GUARD 0
+#endif
+
+#if COOLCHORUS_REALTIME_GUARD
+
+//==============================================================================
+/**
+    Reports allocations, locks and sleeps on a thread inside a
+    ScopedRealtimeSection.
+
+    RealtimeGuard.cpp replaces the allocator and, on Linux, the pthread locks
+    and nanosleep. A violation is recorded with its call stack into storage set
+    aside up front, getReports() turns them into text afterwards and
+    setFailFast (true) aborts on the first one instead. It works in an
+    executable such as CoolChorusCLI's rtcheck, inside a plugin the host
+    usually resolves malloc first.
+*/
+namespace RealtimeGuard
+{
+    enum Violation
+    {
+        allocation = 0,
+        deallocation,
+        lock,
+        wait,
+        sleep,
+        numViolationKinds
+    };
+
+    inline const char* getViolationName (Violation kind) noexcept
+    {
+        static const char* const names[] = { "allocation", "deallocation", "lock", "wait", "sleep" };
+        return names[kind];
+    }
+
+    //Marks the calling thread as realtime for its lifetime, sections nest
+    class ScopedRealtimeSection
+    {
+    public:
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtimeSection)
+    };
+
+    bool isInRealtimeSection() noexcept;
+
+    //Aborts on the first violation rather than recording it
+    void setFailFast (bool shouldFailFast) noexcept;
+
+    //Called by the replacements, does nothing outside a realtime section
+    void reportViolation (Violation kind, size_t bytes) noexcept;
+
+    //Violations since the last clearReports(), including any that found the report storage full
+    int getNumViolations() noexcept;
+
+    //One entry per recorded violation: what it was and the symbolised call stack. Allocates, never call it from a realtime section
+    juce::StringArray getReports();
+
+    void clearReports() noexcept;
+}
+
+#endif
@@ -0,0 +1,195 @@
+/*
+  ==============================================================================
+
+    ScopeComponent.cpp
+
+    The editor's view of the LFO, the delay time it sweeps and the output level.
+
+  ==============================================================================
+*/
+
+#include "ScopeComponent.h"
+
+#if COOLCHORUS_SCOPE
+
+//==============================================================================
+ScopeComponent::ScopeComponent (ScopeFeed& feed)
+    : mFeed (feed)
+{
+    //the background image covers every pixel, so nothing behind needs repainting
+    setOpaque (true);
+
+    mFeed.setActive (true);
+    startTimerHz (frameRate);
+}
+
+ScopeComponent::~ScopeComponent()
+{
+    stopTimer();
+    mFeed.setActive (false);
+}
+
+//==============================================================================
+void ScopeComponent::timerCallback()
+{
+    const int numNewPoints = mFeed.readPoints ([this] (const ScopePoint& point)
+    {
+        mNewestPoint = (mNewestPoint + 1) % maxPoints;
+        mPoints[(size_t) mNewestPoint] = point;
+        mNumPoints = juce::jmin (mNumPoints + 1, maxPoints);
+    });
+
+    float peak = 0;
+    float rms = 0;
+    mFeed.readLevels ([&] (const ScopeLevels& levels)
+    {
+        peak = juce::jmax (peak, levels.peak);
+        rms = juce::jmax (rms, levels.rms);
+    });
+
+    //Rises at once, falls by 20 dB a second
+    const float fall = 20.f / (float) frameRate;
+    mRmsDecibels = juce::jmax (juce::Decibels::gainToDecibels (rms, meterFloorDecibels), mRmsDecibels - fall);
+    mPeakDecibels = juce::jmax (juce::Decibels::gainToDecibels (peak, meterFloorDecibels), mPeakDecibels - fall);
+
+    if (! isShowing())
+        return;
+
+    if (numNewPoints > 0)
+        repaint (mTraceArea);
+
+    //a change under half a dB does not move the meter by a pixel worth redrawing
+    if (std::abs (mRmsDecibels - mPaintedRmsDecibels) > 0.5f || std::abs (mPeakDecibels - mPaintedPeakDecibels) > 0.5f)
+        repaint (mMeterArea);
+}
+
+//==============================================================================
+void ScopeComponent::paint (juce::Graphics& g)
+{
+    const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+
+    if (mBackground.isNull() || scale != mBackgroundScale)
+        renderBackground (scale);
+
+    g.drawImage (mBackground, getLocalBounds().toFloat());
+
+    paintTraces (g);
+    paintMeter (g);
+}
+
+void ScopeComponent::resized()
+{
+    auto area = getLocalBounds().reduced (4);
+    mMeterArea = area.removeFromRight (14);
+    area.removeFromRight (6);
+    mTraceArea = area;
+
+    mBackground = {};
+}
+
+//The frame, centre line and labels, at the display's pixel scale so they stay sharp
+void ScopeComponent::renderBackground (float scale)
+{
+    mBackgroundScale = scale;
+    mBackground = juce::Image (juce::Image::RGB, juce::jmax (1, juce::roundToInt ((float) getWidth() * scale)),
+                               juce::jmax (1, juce::roundToInt ((float) getHeight() * scale)), false);
+
+    juce::Graphics g (mBackground);
+    g.addTransform (juce::AffineTransform::scale (scale));
+
+    const juce::Colour background = getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId);
+    const juce::Colour text = getLookAndFeel().findColour (juce::Label::textColourId);
+
+    g.fillAll (background.darker (0.3f));
+
+    g.setColour (text.withAlpha (0.15f));
+    g.drawHorizontalLine (mTraceArea.getCentreY(), (float) mTraceArea.getX(), (float) mTraceArea.getRight());
+
+    for (int second = 1; second < (int) traceSeconds; ++second)
+        g.drawVerticalLine (juce::roundToInt (getTraceX ((float) second)), (float) mTraceArea.getY(), (float) mTraceArea.getBottom());
+
+    g.setColour (text.withAlpha (0.3f));
+    g.drawRect (mTraceArea);
+    g.drawRect (mMeterArea);
+
+    g.setFont (11.f);
+    g.setColour (juce::Colours::orange);
+    g.drawText ("LFO", mTraceArea.reduced (4, 2), juce::Justification::topLeft);
+    g.setColour (juce::Colours::cyan);
+    g.drawText ("Delay 0 to " + juce::String (maxDelayMs, 0) + " ms", mTraceArea.reduced (4, 2), juce::Justification::bottomLeft);
+}
+
+void ScopeComponent::paintTraces (juce::Graphics& g)
+{
+    if (mNumPoints == 0)
+        return;
+
+    const auto traceArea = mTraceArea.toFloat().reduced (1.f);
+    juce::Path lfoPath;
+    juce::Path delayPath;
+
+    //Newest first, one point per pixel column is all the trace can show
+    float secondsAgo = 0;
+    float lastX = std::numeric_limits<float>::max();
+
+    for (int i = 0; i < mNumPoints && secondsAgo <= traceSeconds; ++i)
+    {
+        const ScopePoint& point = mPoints[(size_t) ((mNewestPoint - i + maxPoints) % maxPoints)];
+        const float x = getTraceX (secondsAgo);
+        secondsAgo += point.seconds;
+
+        if (lastX - x < 1.f)
+            continue;
+
+        const float lfoY = juce::jmap (point.lfo, 1.f, -1.f, traceArea.getY(), traceArea.getBottom());
+        const float delayY = juce::jmap (juce::jlimit (0.f, maxDelayMs, point.delayMs), maxDelayMs, 0.f, traceArea.getY(), traceArea.getBottom());
+
+        if (lastX == std::numeric_limits<float>::max())
+        {
+            lfoPath.startNewSubPath (x, lfoY);
+            delayPath.startNewSubPath (x, delayY);
+        }
+        else
+        {
+            lfoPath.lineTo (x, lfoY);
+            delayPath.lineTo (x, delayY);
+        }
+
+        lastX = x;
+    }
+
+    g.setColour (juce::Colours::orange);
+    g.strokePath (lfoPath, juce::PathStrokeType (1.5f));
+    g.setColour (juce::Colours::cyan);
+    g.strokePath (delayPath, juce::PathStrokeType (1.5f));
+}
+
+void ScopeComponent::paintMeter (juce::Graphics& g)
+{
+    mPaintedRmsDecibels = mRmsDecibels;
+    mPaintedPeakDecibels = mPeakDecibels;
+
+    const auto meterArea = mMeterArea.toFloat().reduced (1.f);
+    const float rmsY = getMeterY (mRmsDecibels);
+    const float peakY = getMeterY (mPeakDecibels);
+
+    g.setColour (juce::Colours::limegreen.withAlpha (0.8f));
+    g.fillRect (meterArea.withTop (rmsY));
+
+    g.setColour (mPeakDecibels >= 0.f ? juce::Colours::red : juce::Colours::white);
+    g.fillRect (meterArea.withTop (peakY).withHeight (2.f));
+}
+
+//==============================================================================
+float ScopeComponent::getTraceX (float secondsAgo) const noexcept
+{
+    return (float) mTraceArea.getRight() - 1.f - secondsAgo / traceSeconds * (float) (mTraceArea.getWidth() - 2);
+}
+
+float ScopeComponent::getMeterY (float decibels) const noexcept
+{
+    const auto meterArea = mMeterArea.toFloat().reduced (1.f);
+    return juce::jmap (juce::jlimit (meterFloorDecibels, 0.f, decibels), meterFloorDecibels, 0.f, meterArea.getBottom(), meterArea.getY());
+}
+
+#endif
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    ScopeComponent.h
+
+    The editor's view of the LFO, the delay time it sweeps and the output level.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ScopeFeed.h"
+#include "ChorusKernels.h"
+
+#if COOLCHORUS_SCOPE
+
+//==============================================================================
+/**
+    Draws the last couple of seconds of a processor's ScopeFeed: the LFO and
+    voice 1's delay time scrolling, and an output meter. Only what changed is
+    repainted, so an idle instance costs one drain per frame. The feed is
+    active for the component's lifetime.
+*/
+class ScopeComponent  : public juce::Component,
+                        private juce::Timer
+{
+public:
+    explicit ScopeComponent (ScopeFeed& feed);
+    ~ScopeComponent() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    //==============================================================================
+    void timerCallback() override;
+    void renderBackground (float scale);
+    void paintTraces (juce::Graphics& g);
+    void paintMeter (juce::Graphics& g);
+
+    float getTraceX (float secondsAgo) const noexcept;
+    float getMeterY (float decibels) const noexcept;
+
+    static constexpr int frameRate = 30;
+    static constexpr float traceSeconds = 2.f;
+    static constexpr int maxPoints = 4096; //more than traceSeconds of the shortest sub-blocks at any rate
+    static constexpr float meterFloorDecibels = -60.f;
+    static constexpr float maxDelayMs = ChorusType::maxDelay * 1000.f;
+
+    ScopeFeed& mFeed;
+
+    //The newest points, a ring with mNewestPoint the last one written
+    std::array<ScopePoint, maxPoints> mPoints;
+    int mNewestPoint = 0;
+    int mNumPoints = 0;
+
+    //Meter readings in decibels, falling back at a fixed rate once the level drops
+    float mRmsDecibels = meterFloorDecibels;
+    float mPeakDecibels = meterFloorDecibels;
+    float mPaintedRmsDecibels = meterFloorDecibels;
+    float mPaintedPeakDecibels = meterFloorDecibels;
+
+    juce::Rectangle<int> mTraceArea;
+    juce::Rectangle<int> mMeterArea;
+
+    juce::Image mBackground;
+    float mBackgroundScale = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScopeComponent)
+};
+
+#endif
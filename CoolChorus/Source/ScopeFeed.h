@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    ScopeFeed.h
+
+    The LFO, the delay time and the output level, passed from the audio
+    thread to the editor's scope without locks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Compiles the feed and the editor's scope in or out
+#ifndef COOLCHORUS_SCOPE
+ #define COOLCHORUS_SCOPE 1
+#endif
+
+#if COOLCHORUS_SCOPE
+
+//==============================================================================
+//One point of the modulation trace, taken at the end of an engine sub-block from voice 1 of the first channel
+struct ScopePoint
+{
+    float lfo;          //-1 to 1
+    float delayMs;      //the smoothed delay time the voice reads at
+    float seconds;      //audio since the previous point
+};
+
+//The output of one processBlock across every processed channel
+struct ScopeLevels
+{
+    float peak;
+    float rms;
+};
+
+//==============================================================================
+/**
+    Decimated modulation and levels for a scope: one ScopePoint per sub-block
+    from the engine and one ScopeLevels per block from the processor, each in
+    its own lock free ring that drops records when full. Nothing is pushed
+    until a reader calls setActive (true). The read functions belong to the
+    one reader on the message thread.
+*/
+class ScopeFeed
+{
+public:
+    ScopeFeed()
+        : mPointFifo (pointCapacity), mLevelFifo (levelCapacity)
+    {
+    }
+
+    //Reader: starts or stops the feed, records left over from before are discarded on the way in
+    void setActive (bool shouldBeActive) noexcept
+    {
+        if (shouldBeActive)
+        {
+            mPointFifo.finishedRead (mPointFifo.getNumReady());
+            mLevelFifo.finishedRead (mLevelFifo.getNumReady());
+        }
+
+        mActive.store (shouldBeActive, std::memory_order_release);
+    }
+
+    //Audio thread
+    bool isActive() const noexcept                          { return mActive.load (std::memory_order_relaxed); }
+    void pushPoint (const ScopePoint& point) noexcept       { push (mPointFifo, mPoints.data(), point); }
+    void pushLevels (const ScopeLevels& levels) noexcept    { push (mLevelFifo, mLevels.data(), levels); }
+
+    //Reader: calls callback with every record written since the last call, oldest first, and returns how many there were
+    template <typename Callback>
+    int readPoints (Callback&& callback)                    { return read (mPointFifo, mPoints.data(), callback); }
+
+    template <typename Callback>
+    int readLevels (Callback&& callback)                    { return read (mLevelFifo, mLevels.data(), callback); }
+
+    //Peak and RMS over every channel
+    template <typename SampleType>
+    static ScopeLevels measure (const SampleType* const* channels, int numChannels, int numSamples) noexcept
+    {
+        SampleType peak = 0;
+        SampleType sumOfSquares = 0;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            accumulateLevels (channels[channel], numSamples, peak, sumOfSquares);
+
+        const int count = juce::jmax (1, numChannels * numSamples);
+        return { (float) peak, (float) std::sqrt (sumOfSquares / (SampleType) count) };
+    }
+
+private:
+    //==============================================================================
+    //Runs in eight independent lanes, which the compiler turns into vector ops as it cannot reorder a single running sum
+    template <typename SampleType>
+    static void accumulateLevels (const SampleType* samples, int numSamples, SampleType& peak, SampleType& sumOfSquares) noexcept
+    {
+        constexpr int numLanes = 8;
+        SampleType lanePeaks[numLanes] = {};
+        SampleType laneSums[numLanes] = {};
+        int i = 0;
+
+        for (; i + numLanes <= numSamples; i += numLanes)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const SampleType sample = samples[i + lane];
+                lanePeaks[lane] = juce::jmax (lanePeaks[lane], std::abs (sample));
+                laneSums[lane] += sample * sample;
+            }
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            lanePeaks[0] = juce::jmax (lanePeaks[0], std::abs (samples[i]));
+            laneSums[0] += samples[i] * samples[i];
+        }
+
+        for (int lane = 0; lane < numLanes; ++lane)
+        {
+            peak = juce::jmax (peak, lanePeaks[lane]);
+            sumOfSquares += laneSums[lane];
+        }
+    }
+
+    template <typename Record>
+    static void push (juce::AbstractFifo& fifo, Record* records, const Record& record) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return;
+
+        records[size1 > 0 ? start1 : start2] = record;
+        fifo.finishedWrite (1);
+    }
+
+    template <typename Record, typename Callback>
+    static int read (juce::AbstractFifo& fifo, const Record* records, Callback& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            callback (records[start1 + i]);
+
+        for (int i = 0; i < size2; ++i)
+            callback (records[start2 + i]);
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    //==============================================================================
+    static constexpr int pointCapacity = 4096; //seconds of the flanger's short sub-blocks, the scope drains them 30 times a second
+    static constexpr int levelCapacity = 1024;
+
+    std::atomic<bool> mActive { false };
+
+    juce::AbstractFifo mPointFifo;
+    std::array<ScopePoint, pointCapacity> mPoints;
+
+    juce::AbstractFifo mLevelFifo;
+    std::array<ScopeLevels, levelCapacity> mLevels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScopeFeed)
+};
+
+#endif
@@ -0,0 +1,332 @@
+/*
+  ==============================================================================
+
+    StereoFrame.h
+
+    One left/right sample pair held in a single SIMD register.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#ifndef COOLCHORUS_USE_SIMD
+ #define COOLCHORUS_USE_SIMD 1
+#endif
+
+#if COOLCHORUS_USE_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+ #define COOLCHORUS_SIMD_SSE2 1
+ #include <emmintrin.h>
+#elif COOLCHORUS_USE_SIMD && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+ #define COOLCHORUS_SIMD_NEON 1
+ #include <arm_neon.h>
+#endif
+
+//==============================================================================
+/**
+    A stereo sample frame the chorus kernel treats as one value, so the
+    interleaved delay line is read, interpolated and mixed with single vector
+    instructions. This plain version serves every target without a
+    specialisation below and builds with COOLCHORUS_USE_SIMD=0. SSE2 and NEON
+    specialise it, 32 bit ARM has no double vectors and uses this one.
+*/
+template <typename FloatType>
+struct StereoFrame
+{
+    using SampleType = FloatType;
+
+    SampleType left, right;
+
+    StereoFrame() = default;
+    StereoFrame(SampleType l, SampleType r) noexcept : left(l), right(r) {}
+
+    static StereoFrame expand(SampleType v) noexcept                { return { v, v }; }
+    static StereoFrame load(const SampleType* frame) noexcept       { return { frame[0], frame[1] }; }
+    void store(SampleType* frame) const noexcept                    { frame[0] = left; frame[1] = right; }
+
+    SampleType getLeft() const noexcept                              { return left; }
+    SampleType getRight() const noexcept                             { return right; }
+
+    StereoFrame operator+(StereoFrame other) const noexcept         { return { left + other.left, right + other.right }; }
+    StereoFrame operator-(StereoFrame other) const noexcept         { return { left - other.left, right - other.right }; }
+    StereoFrame operator*(StereoFrame other) const noexcept         { return { left * other.left, right * other.right }; }
+    StereoFrame operator/(StereoFrame other) const noexcept         { return { left / other.left, right / other.right }; }
+
+    //Per lane a < b ? ifLess : otherwise
+    static StereoFrame selectLessThan(StereoFrame a, StereoFrame b, StereoFrame ifLess, StereoFrame otherwise) noexcept
+    {
+        return { a.left < b.left ? ifLess.left : otherwise.left,
+                 a.right < b.right ? ifLess.right : otherwise.right };
+    }
+
+    //Adds amount to every lane that is below zero, used for the ring buffer wrap
+    static StereoFrame wrapBelowZero(StereoFrame position, StereoFrame amount) noexcept
+    {
+        return { position.left + (position.left < 0 ? amount.left : 0),
+                 position.right + (position.right < 0 ? amount.right : 0) };
+    }
+
+    //Splits a positive position into its integer parts and returns the fractional part
+    static StereoFrame splitIndex(StereoFrame position, int& l, int& r) noexcept
+    {
+        l = (int) position.left;
+        r = (int) position.right;
+        return { position.left - (SampleType) l, position.right - (SampleType) r };
+    }
+
+    //Reads frames x and x + 1 for interpolation, left lane from frame index l, right lane from frame index r
+    static void gatherInterleaved(const SampleType* buffer, int l, int r, StereoFrame& x0, StereoFrame& x1) noexcept
+    {
+        x0 = { buffer[2 * l], buffer[2 * r + 1] };
+        x1 = { buffer[2 * l + 2], buffer[2 * r + 3] };
+    }
+};
+
+#if COOLCHORUS_SIMD_SSE2
+//==============================================================================
+template <>
+struct StereoFrame<float>
+{
+    using SampleType = float;
+
+    __m128 value;
+
+    StereoFrame() = default;
+    explicit StereoFrame(__m128 v) noexcept : value(v) {}
+    StereoFrame(float left, float right) noexcept : value(_mm_setr_ps(left, right, 0.f, 0.f)) {}
+
+    static StereoFrame expand(float v) noexcept                { return StereoFrame(_mm_set1_ps(v)); }
+    static StereoFrame load(const float* frame) noexcept       { return StereoFrame(_mm_castpd_ps(_mm_load_sd((const double*) frame))); }
+    void store(float* frame) const noexcept                    { _mm_store_sd((double*) frame, _mm_castps_pd(value)); }
+
+    float getLeft() const noexcept                              { return _mm_cvtss_f32(value); }
+    float getRight() const noexcept                             { return _mm_cvtss_f32(_mm_shuffle_ps(value, value, _MM_SHUFFLE(1, 1, 1, 1))); }
+
+    StereoFrame operator+(StereoFrame other) const noexcept    { return StereoFrame(_mm_add_ps(value, other.value)); }
+    StereoFrame operator-(StereoFrame other) const noexcept    { return StereoFrame(_mm_sub_ps(value, other.value)); }
+    StereoFrame operator*(StereoFrame other) const noexcept    { return StereoFrame(_mm_mul_ps(value, other.value)); }
+    StereoFrame operator/(StereoFrame other) const noexcept    { return StereoFrame(_mm_div_ps(value, other.value)); }
+
+    static StereoFrame selectLessThan(StereoFrame a, StereoFrame b, StereoFrame ifLess, StereoFrame otherwise) noexcept
+    {
+        const __m128 isLess = _mm_cmplt_ps(a.value, b.value);
+        return StereoFrame(_mm_or_ps(_mm_and_ps(isLess, ifLess.value), _mm_andnot_ps(isLess, otherwise.value)));
+    }
+
+    static StereoFrame wrapBelowZero(StereoFrame position, StereoFrame amount) noexcept
+    {
+        const __m128 isNegative = _mm_cmplt_ps(position.value, _mm_setzero_ps());
+        return StereoFrame(_mm_add_ps(position.value, _mm_and_ps(isNegative, amount.value)));
+    }
+
+    static StereoFrame splitIndex(StereoFrame position, int& left, int& right) noexcept
+    {
+        const __m128i index = _mm_cvttps_epi32(position.value);
+        left = _mm_cvtsi128_si32(index);
+        right = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(1, 1, 1, 1)));
+        return StereoFrame(_mm_sub_ps(position.value, _mm_cvtepi32_ps(index)));
+    }
+
+    static void gatherInterleaved(const float* buffer, int left, int right, StereoFrame& x0, StereoFrame& x1) noexcept
+    {
+        const __m128 a = _mm_loadu_ps(buffer + 2 * left);  //L[l] R[l] L[l+1] R[l+1]
+        const __m128 b = _mm_loadu_ps(buffer + 2 * right); //L[r] R[r] L[r+1] R[r+1]
+        __m128 mixed = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 2, 0)); //L[l] L[l+1] R[r] R[r+1]
+        mixed = _mm_shuffle_ps(mixed, mixed, _MM_SHUFFLE(3, 1, 2, 0)); //L[l] R[r] L[l+1] R[r+1]
+        x0.value = mixed;
+        x1.value = _mm_movehl_ps(mixed, mixed);
+    }
+};
+
+//==============================================================================
+template <>
+struct StereoFrame<double>
+{
+    using SampleType = double;
+
+    __m128d value;
+
+    StereoFrame() = default;
+    explicit StereoFrame(__m128d v) noexcept : value(v) {}
+    StereoFrame(double left, double right) noexcept : value(_mm_setr_pd(left, right)) {}
+
+    static StereoFrame expand(double v) noexcept               { return StereoFrame(_mm_set1_pd(v)); }
+    static StereoFrame load(const double* frame) noexcept      { return StereoFrame(_mm_loadu_pd(frame)); }
+    void store(double* frame) const noexcept                   { _mm_storeu_pd(frame, value); }
+
+    double getLeft() const noexcept                             { return _mm_cvtsd_f64(value); }
+    double getRight() const noexcept                            { return _mm_cvtsd_f64(_mm_unpackhi_pd(value, value)); }
+
+    StereoFrame operator+(StereoFrame other) const noexcept    { return StereoFrame(_mm_add_pd(value, other.value)); }
+    StereoFrame operator-(StereoFrame other) const noexcept    { return StereoFrame(_mm_sub_pd(value, other.value)); }
+    StereoFrame operator*(StereoFrame other) const noexcept    { return StereoFrame(_mm_mul_pd(value, other.value)); }
+    StereoFrame operator/(StereoFrame other) const noexcept    { return StereoFrame(_mm_div_pd(value, other.value)); }
+
+    static StereoFrame selectLessThan(StereoFrame a, StereoFrame b, StereoFrame ifLess, StereoFrame otherwise) noexcept
+    {
+        const __m128d isLess = _mm_cmplt_pd(a.value, b.value);
+        return StereoFrame(_mm_or_pd(_mm_and_pd(isLess, ifLess.value), _mm_andnot_pd(isLess, otherwise.value)));
+    }
+
+    static StereoFrame wrapBelowZero(StereoFrame position, StereoFrame amount) noexcept
+    {
+        const __m128d isNegative = _mm_cmplt_pd(position.value, _mm_setzero_pd());
+        return StereoFrame(_mm_add_pd(position.value, _mm_and_pd(isNegative, amount.value)));
+    }
+
+    static StereoFrame splitIndex(StereoFrame position, int& left, int& right) noexcept
+    {
+        const __m128i index = _mm_cvttpd_epi32(position.value); //both ints in the low half
+        left = _mm_cvtsi128_si32(index);
+        right = _mm_cvtsi128_si32(_mm_shuffle_epi32(index, _MM_SHUFFLE(1, 1, 1, 1)));
+        return StereoFrame(_mm_sub_pd(position.value, _mm_cvtepi32_pd(index)));
+    }
+
+    //A double frame fills a register, so each frame is its own load and the lanes are blended
+    static void gatherInterleaved(const double* buffer, int left, int right, StereoFrame& x0, StereoFrame& x1) noexcept
+    {
+        const __m128d a0 = _mm_loadu_pd(buffer + 2 * left);      //L[l] R[l]
+        const __m128d a1 = _mm_loadu_pd(buffer + 2 * left + 2);  //L[l+1] R[l+1]
+        const __m128d b0 = _mm_loadu_pd(buffer + 2 * right);     //L[r] R[r]
+        const __m128d b1 = _mm_loadu_pd(buffer + 2 * right + 2); //L[r+1] R[r+1]
+        x0.value = _mm_move_sd(b0, a0); //L[l] R[r]
+        x1.value = _mm_move_sd(b1, a1); //L[l+1] R[r+1]
+    }
+};
+
+#elif COOLCHORUS_SIMD_NEON
+//==============================================================================
+template <>
+struct StereoFrame<float>
+{
+    using SampleType = float;
+
+    float32x2_t value;
+
+    StereoFrame() = default;
+    explicit StereoFrame(float32x2_t v) noexcept : value(v) {}
+    StereoFrame(float left, float right) noexcept : value(vset_lane_f32(right, vdup_n_f32(left), 1)) {}
+
+    static StereoFrame expand(float v) noexcept                { return StereoFrame(vdup_n_f32(v)); }
+    static StereoFrame load(const float* frame) noexcept       { return StereoFrame(vld1_f32(frame)); }
+    void store(float* frame) const noexcept                    { vst1_f32(frame, value); }
+
+    float getLeft() const noexcept                              { return vget_lane_f32(value, 0); }
+    float getRight() const noexcept                             { return vget_lane_f32(value, 1); }
+
+    StereoFrame operator+(StereoFrame other) const noexcept    { return StereoFrame(vadd_f32(value, other.value)); }
+    StereoFrame operator-(StereoFrame other) const noexcept    { return StereoFrame(vsub_f32(value, other.value)); }
+    StereoFrame operator*(StereoFrame other) const noexcept    { return StereoFrame(vmul_f32(value, other.value)); }
+
+   #if defined(__aarch64__) || defined(_M_ARM64)
+    StereoFrame operator/(StereoFrame other) const noexcept    { return StereoFrame(vdiv_f32(value, other.value)); }
+   #else
+    //32 bit NEON has no divide, and a reciprocal estimate would no longer match the scalar reference
+    StereoFrame operator/(StereoFrame other) const noexcept    { return StereoFrame(getLeft() / other.getLeft(), getRight() / other.getRight()); }
+   #endif
+
+    static StereoFrame selectLessThan(StereoFrame a, StereoFrame b, StereoFrame ifLess, StereoFrame otherwise) noexcept
+    {
+        return StereoFrame(vbsl_f32(vclt_f32(a.value, b.value), ifLess.value, otherwise.value));
+    }
+
+    static StereoFrame wrapBelowZero(StereoFrame position, StereoFrame amount) noexcept
+    {
+        const uint32x2_t isNegative = vclt_f32(position.value, vdup_n_f32(0.f));
+        const float32x2_t wrapped = vreinterpret_f32_u32(vand_u32(isNegative, vreinterpret_u32_f32(amount.value)));
+        return StereoFrame(vadd_f32(position.value, wrapped));
+    }
+
+    static StereoFrame splitIndex(StereoFrame position, int& left, int& right) noexcept
+    {
+        const int32x2_t index = vcvt_s32_f32(position.value);
+        left = vget_lane_s32(index, 0);
+        right = vget_lane_s32(index, 1);
+        return StereoFrame(vsub_f32(position.value, vcvt_f32_s32(index)));
+    }
+
+    static void gatherInterleaved(const float* buffer, int left, int right, StereoFrame& x0, StereoFrame& x1) noexcept
+    {
+        const float32x4_t a = vld1q_f32(buffer + 2 * left);
+        const float32x4_t b = vld1q_f32(buffer + 2 * right);
+        const float32x2x2_t lanes = vtrn_f32(vget_low_f32(a), vget_high_f32(a));   //{L[l] L[l+1]}, {R[l] R[l+1]}
+        const float32x2x2_t lanesB = vtrn_f32(vget_low_f32(b), vget_high_f32(b));  //{L[r] L[r+1]}, {R[r] R[r+1]}
+        const float32x2x2_t frames = vtrn_f32(lanes.val[0], lanesB.val[1]);          //{L[l] R[r]}, {L[l+1] R[r+1]}
+        x0.value = frames.val[0];
+        x1.value = frames.val[1];
+    }
+};
+
+ #if defined(__aarch64__) || defined(_M_ARM64)
+//==============================================================================
+template <>
+struct StereoFrame<double>
+{
+    using SampleType = double;
+
+    float64x2_t value;
+
+    StereoFrame() = default;
+    explicit StereoFrame(float64x2_t v) noexcept : value(v) {}
+    StereoFrame(double left, double right) noexcept : value(vsetq_lane_f64(right, vdupq_n_f64(left), 1)) {}
+
+    static StereoFrame expand(double v) noexcept               { return StereoFrame(vdupq_n_f64(v)); }
+    static StereoFrame load(const double* frame) noexcept      { return StereoFrame(vld1q_f64(frame)); }
+    void store(double* frame) const noexcept                   { vst1q_f64(frame, value); }
+
+    double getLeft() const noexcept                             { return vgetq_lane_f64(value, 0); }
+    double getRight() const noexcept                            { return vgetq_lane_f64(value, 1); }
+
+    StereoFrame operator+(StereoFrame other) const noexcept    { return StereoFrame(vaddq_f64(value, other.value)); }
+    StereoFrame operator-(StereoFrame other) const noexcept    { return StereoFrame(vsubq_f64(value, other.value)); }
+    StereoFrame operator*(StereoFrame other) const noexcept    { return StereoFrame(vmulq_f64(value, other.value)); }
+    StereoFrame operator/(StereoFrame other) const noexcept    { return StereoFrame(vdivq_f64(value, other.value)); }
+
+    static StereoFrame selectLessThan(StereoFrame a, StereoFrame b, StereoFrame ifLess, StereoFrame otherwise) noexcept
+    {
+        return StereoFrame(vbslq_f64(vcltq_f64(a.value, b.value), ifLess.value, otherwise.value));
+    }
+
+    static StereoFrame wrapBelowZero(StereoFrame position, StereoFrame amount) noexcept
+    {
+        const uint64x2_t isNegative = vcltq_f64(position.value, vdupq_n_f64(0.0));
+        const float64x2_t wrapped = vreinterpretq_f64_u64(vandq_u64(isNegative, vreinterpretq_u64_f64(amount.value)));
+        return StereoFrame(vaddq_f64(position.value, wrapped));
+    }
+
+    static StereoFrame splitIndex(StereoFrame position, int& left, int& right) noexcept
+    {
+        const int64x2_t index = vcvtq_s64_f64(position.value);
+        left = (int) vgetq_lane_s64(index, 0);
+        right = (int) vgetq_lane_s64(index, 1);
+        return StereoFrame(vsubq_f64(position.value, vcvtq_f64_s64(index)));
+    }
+
+    static void gatherInterleaved(const double* buffer, int left, int right, StereoFrame& x0, StereoFrame& x1) noexcept
+    {
+        x0.value = vcopyq_laneq_f64(vld1q_f64(buffer + 2 * left), 1, vld1q_f64(buffer + 2 * right), 1);         //L[l] R[r]
+        x1.value = vcopyq_laneq_f64(vld1q_f64(buffer + 2 * left + 2), 1, vld1q_f64(buffer + 2 * right + 2), 1); //L[l+1] R[r+1]
+    }
+};
+ #endif
+#endif
+
+//==============================================================================
+//The same frame at another sample type, e.g. the double delay fraction the float kernel interpolates with
+template <typename To, typename From>
+inline StereoFrame<To> convertFrame(StereoFrame<From> frame) noexcept
+{
+    if constexpr (std::is_same_v<To, From>)
+        return frame;
+   #if COOLCHORUS_SIMD_SSE2
+    else if constexpr (std::is_same_v<To, float> && std::is_same_v<From, double>)
+        return StereoFrame<float>(_mm_cvtpd_ps(frame.value));
+   #elif COOLCHORUS_SIMD_NEON && (defined(__aarch64__) || defined(_M_ARM64))
+    else if constexpr (std::is_same_v<To, float> && std::is_same_v<From, double>)
+        return StereoFrame<float>(vcvt_f32_f64(frame.value));
+   #endif
+    else
+        return { (To) frame.getLeft(), (To) frame.getRight() };
+}
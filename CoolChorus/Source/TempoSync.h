@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    TempoSync.h
+
+    Locks the LFO to the host's tempo and song position.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace TempoSync
+{
+    enum Mode
+    {
+        free = 0,
+        tempo,
+        numModes
+    };
+
+    inline juce::StringArray getModeNames() { return { "Free", "Tempo" }; }
+
+    //Note values of one LFO cycle, D dotted and T triplet
+    inline juce::StringArray getDivisionNames()
+    {
+        return { "4/1", "2/1", "1/1", "1/2", "1/2D", "1/2T", "1/4", "1/4D", "1/4T",
+                 "1/8", "1/8D", "1/8T", "1/16", "1/16D", "1/16T", "1/32" };
+    }
+
+    constexpr int quarterNoteDivision = 6;
+
+    //Quarter notes, the unit of the host's PPQ position, in one LFO cycle of each division
+    constexpr double beatsPerCycle[] = { 16.0, 8.0, 4.0, 2.0, 3.0, 4.0 / 3.0, 1.0, 1.5, 2.0 / 3.0,
+                                         0.5, 0.75, 1.0 / 3.0, 0.25, 0.375, 1.0 / 6.0, 0.125 };
+
+    constexpr int numDivisions = (int) (sizeof (beatsPerCycle) / sizeof (beatsPerCycle[0]));
+
+    inline double getBeatsPerCycle (int division) noexcept
+    {
+        return beatsPerCycle[juce::jlimit (0, numDivisions - 1, division)];
+    }
+}
+
+//==============================================================================
+/**
+    Turns the host's position into the LFO's rate and place in the cycle, once
+    per block.
+
+    While the transport runs the LFO is put at the song position every block,
+    so every pass modulates the same, and a block that does not continue the
+    last one is a jump that also restarts the random shape. Stopped, the LFO
+    runs free at the tempo's rate. Without a tempo the Rate parameter is used.
+*/
+class TransportSync
+{
+public:
+    struct Position
+    {
+        bool hasTempo = false;      //rate is the tempo's
+        bool isPlaying = false;     //cycles is the song position
+        bool isJump = false;        //the song position did not follow on from the last block
+        float rate = 0;             //Hz
+        double cycles = 0;          //LFO cycles from the start of the song
+    };
+
+    //Forgets the last block, the next one that plays counts as a jump
+    void reset() noexcept
+    {
+        mWasPlaying = false;
+    }
+
+    //Audio thread only, reads the play head once
+    Position update (juce::AudioPlayHead* playHead, int division, double sampleRate, int numSamples) noexcept
+    {
+        Position result;
+
+        if (playHead == nullptr)
+        {
+            mWasPlaying = false;
+            return result;
+        }
+
+        const auto info = playHead->getPosition();
+
+        if (! info.hasValue() || ! info->getBpm().hasValue() || *info->getBpm() <= 0.0)
+        {
+            mWasPlaying = false;
+            return result;
+        }
+
+        const double bpm = *info->getBpm();
+        const double cycleBeats = TempoSync::getBeatsPerCycle (division);
+
+        result.hasTempo = true;
+        result.rate = (float) (bpm / 60.0 / cycleBeats);
+
+        if (! info->getIsPlaying() || ! info->getPpqPosition().hasValue())
+        {
+            mWasPlaying = false;
+            return result;
+        }
+
+        const double ppq = *info->getPpqPosition();
+
+        result.isPlaying = true;
+        result.cycles = ppq / cycleBeats;
+        result.isJump = ! mWasPlaying || division != mDivision || std::abs (ppq - mExpectedPpq) > jumpToleranceBeats;
+
+        mWasPlaying = true;
+        mDivision = division;
+        mExpectedPpq = ppq + (double) numSamples * bpm / (60.0 * sampleRate);
+        return result;
+    }
+
+private:
+    //More than a tempo change within a block moves the position by, less than any relocation
+    static constexpr double jumpToleranceBeats = 1.0e-3;
+
+    double mExpectedPpq = 0;
+    int mDivision = -1;
+    bool mWasPlaying = false;
+};
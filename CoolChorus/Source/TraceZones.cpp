@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    TraceZones.cpp
+
+    The per thread event buffers behind TraceZones.h and their JSON export.
+
+  ==============================================================================
+*/
+
+#include "TraceZones.h"
+
+#if COOLCHORUS_TRACE
+
+#include <atomic>
+#include <cstdio>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        juce::int64 startTicks;
+        juce::int64 endTicks;
+    };
+
+    struct ThreadBuffer
+    {
+        juce::HeapBlock<Event> events;
+        std::atomic<int> numEvents { 0 };
+    };
+
+    juce::OwnedArray<ThreadBuffer> buffers;
+    int maxEvents = 0;
+    juce::int64 startTicks = 0;
+
+    std::atomic<bool> recording { false };
+    std::atomic<int> generation { 0 };  //bumped by start(), so threads claim a buffer again
+    std::atomic<int> numClaimed { 0 };
+    std::atomic<juce::int64> numDropped { 0 };
+
+    thread_local int claimedGeneration = -1;
+    thread_local ThreadBuffer* claimedBuffer = nullptr;
+
+    double toMicroseconds (juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds (ticks - startTicks) * 1.0e6;
+    }
+}
+
+//==============================================================================
+void TraceZones::start (int maxThreads, int maxEventsPerThread)
+{
+    stop();
+    buffers.clear();
+
+    for (int i = 0; i < maxThreads; ++i)
+        buffers.add (new ThreadBuffer())->events.allocate ((size_t) maxEventsPerThread, false);
+
+    maxEvents = maxEventsPerThread;
+    numClaimed = 0;
+    numDropped = 0;
+    startTicks = juce::Time::getHighResolutionTicks();
+
+    ++generation;
+    recording = true;
+}
+
+void TraceZones::stop() noexcept
+{
+    recording = false;
+}
+
+void TraceZones::record (const char* name, juce::int64 zoneStartTicks, juce::int64 zoneEndTicks) noexcept
+{
+    if (! recording.load (std::memory_order_relaxed))
+        return;
+
+    const int currentGeneration = generation.load (std::memory_order_relaxed);
+
+    if (claimedGeneration != currentGeneration)
+    {
+        const int slot = numClaimed.fetch_add (1);
+        claimedBuffer = slot < buffers.size() ? buffers.getUnchecked (slot) : nullptr;
+        claimedGeneration = currentGeneration;
+    }
+
+    //only this thread writes its buffer, the release store publishes the event to writeJSON()
+    const int index = claimedBuffer != nullptr ? claimedBuffer->numEvents.load (std::memory_order_relaxed) : maxEvents;
+
+    if (index >= maxEvents)
+    {
+        numDropped.fetch_add (1, std::memory_order_relaxed);
+        return;
+    }
+
+    claimedBuffer->events[index] = { name, zoneStartTicks, zoneEndTicks };
+    claimedBuffer->numEvents.store (index + 1, std::memory_order_release);
+}
+
+juce::int64 TraceZones::getNumEvents() noexcept
+{
+    juce::int64 numEvents = 0;
+
+    for (auto* buffer : buffers)
+        numEvents += buffer->numEvents.load (std::memory_order_acquire);
+
+    return numEvents;
+}
+
+juce::int64 TraceZones::getNumDropped() noexcept
+{
+    return numDropped.load();
+}
+
+bool TraceZones::writeJSON (juce::OutputStream& stream)
+{
+    //Formatted into a fixed buffer rather than through juce::String, a long render has millions of events
+    char line[256];
+    bool ok = true;
+
+    const auto writeLine = [&] (int length)
+    {
+        ok = ok && length > 0 && stream.write (line, (size_t) juce::jmin (length, (int) sizeof (line) - 1));
+    };
+
+    writeLine (std::snprintf (line, sizeof (line), "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"));
+    bool first = true;
+
+    //tid is the order the threads claimed their buffers in, named so the viewer lists them that way
+    for (int thread = 0; thread < juce::jmin (numClaimed.load(), buffers.size()); ++thread)
+    {
+        const auto& buffer = *buffers.getUnchecked (thread);
+        const int numEvents = buffer.numEvents.load (std::memory_order_acquire);
+
+        writeLine (std::snprintf (line, sizeof (line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}",
+                                  first ? "" : ",\n", thread + 1, thread + 1));
+        first = false;
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const Event& event = buffer.events[i];
+            const double start = toMicroseconds (event.startTicks);
+
+            writeLine (std::snprintf (line, sizeof (line), ",\n{\"name\":\"%s\",\"cat\":\"CoolChorus\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                                      event.name, thread + 1, start, toMicroseconds (event.endTicks) - start));
+        }
+    }
+
+    writeLine (std::snprintf (line, sizeof (line), "\n]}\n"));
+    stream.flush();
+    return ok;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    TraceZones.h
+
+    Scoped timing zones inside processBlock, exported as Chrome trace events.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//Compiles the zones in, for profiling builds only
+#ifndef COOLCHORUS_TRACE
+ #define COOLCHORUS_TRACE 0
+#endif
+
+#if COOLCHORUS_TRACE
+ //Times the rest of the enclosing scope as one zone, name has to be a string literal
+ #define COOLCHORUS_TRACE_ZONE(name) const TraceZones::ScopedZone JUCE_JOIN_MACRO (traceZone, __LINE__) (name)
+#else
+ #define COOLCHORUS_TRACE_ZONE(name)
+#endif
+
+#if COOLCHORUS_TRACE
+
+//==============================================================================
+/**
+    Where the time inside a block goes. Each COOLCHORUS_TRACE_ZONE records its
+    name, start and end into the buffer start() set aside for its thread, with
+    no lock or allocation, events that do not fit are counted as dropped.
+    writeJSON() writes Chrome's trace event format. Compiled in with
+    COOLCHORUS_TRACE=1, otherwise the zones expand to nothing.
+*/
+namespace TraceZones
+{
+    //Allocates maxEventsPerThread events for each of maxThreads threads and starts recording, discarding any earlier events
+    void start (int maxThreads, int maxEventsPerThread);
+
+    //Zones that finish after this are not recorded
+    void stop() noexcept;
+
+    //Called by ScopedZone
+    void record (const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept;
+
+    juce::int64 getNumEvents() noexcept;
+    juce::int64 getNumDropped() noexcept;
+
+    //Every event since start() as a Chrome trace JSON object, call it once the recording threads have finished
+    bool writeJSON (juce::OutputStream& stream);
+
+    //==============================================================================
+    class ScopedZone
+    {
+    public:
+        explicit ScopedZone (const char* name) noexcept
+            : mName (name), mStartTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedZone() noexcept
+        {
+            record (mName, mStartTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        const char* const mName;
+        const juce::int64 mStartTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedZone)
+    };
+}
+
+#endif
@@ -0,0 +1,628 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../CoolChorus/Source/PluginProcessor.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+namespace
+{
+    juce::uint64 readCycleCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #else
+        return 0;
+       #endif
+    }
+
+    juce::String getSIMDName()
+    {
+       #if COOLCHORUS_SIMD_SSE2
+        return "SSE2";
+       #elif COOLCHORUS_SIMD_NEON
+        return "NEON";
+       #else
+        return "scalar";
+       #endif
+    }
+
+    juce::String makeKey (const juce::String& typeName, const juce::String& patternName, const juce::String& precisionName,
+                          int sampleRate, int blockSize, int numChannels, const juce::String& oversamplingName,
+                          const juce::String& interpolationName)
+    {
+        //stereo keys carry no channel count and keys without oversampling no factor, so runs from before --channels and
+        //--oversampling still match
+        return typeName + " " + patternName + " " + precisionName + " " + juce::String (sampleRate) + " " + juce::String (blockSize)
+             + (numChannels != 2 ? " " + juce::String (numChannels) + "ch" : juce::String())
+             + (oversamplingName != "off" ? " " + oversamplingName : juce::String()) + " " + interpolationName;
+    }
+
+    template <typename SampleType>
+    void fillWithNoise (juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* samples = buffer.getWritePointer (channel);
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                samples[i] = (SampleType) (0.25f * (random.nextFloat() * 2.f - 1.f));
+        }
+    }
+
+    //written after every LFO case, so the rendering is not optimised away
+    volatile float lfoBenchmarkSink = 0;
+
+    //the same for the interpolated reads
+    volatile float interpolationBenchmarkSink = 0;
+
+    //Level in dB and phase delay error in samples of a sine read at a fixed fraction, once the Thiran state has settled
+    template <typename Interpolator>
+    void measureResponse (double frequency, double sampleRate, float fraction, double& gain, double& delayError)
+    {
+        const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const int settleSamples = 256, numSamples = 4800; //a whole number of cycles at 10 and 15 kHz
+        StereoFrame<float> output = StereoFrame<float>::expand (0.f);
+        double inPhase = 0, quadrature = 0;
+
+        for (int n = 0; n < settleSamples + numSamples; ++n)
+        {
+            StereoFrame<float> x[Interpolator::numPoints];
+
+            for (int i = 0; i < Interpolator::numPoints; ++i)
+                x[i] = StereoFrame<float>::expand ((float) std::sin (omega * (n - Interpolator::pointsBefore + i)));
+
+            output = Interpolator::process (x, StereoFrame<float>::expand (fraction), output);
+
+            //demodulated against the exact read, fraction past frame x0 = n
+            if (n >= settleSamples)
+            {
+                inPhase += output.getLeft() * std::sin (omega * (n + fraction));
+                quadrature += output.getLeft() * std::cos (omega * (n + fraction));
+            }
+        }
+
+        gain = juce::Decibels::gainToDecibels (2.0 * std::sqrt (inPhase * inPhase + quadrature * quadrature) / numSamples, -200.0);
+        delayError = -std::atan2 (quadrature, inPhase) / omega;
+    }
+
+    template <typename Interpolator>
+    void measureInterpolator (InterpolationBenchmarkCase& interpolationCase, const std::vector<float>& input, int numReads, int repetitions)
+    {
+        const double sampleRate = 48000.0;
+        const int numFractions = 64;
+
+        interpolationCase.gainAt10k = interpolationCase.gainAt15k = std::numeric_limits<double>::max();
+
+        for (int i = 0; i <= numFractions; ++i)
+        {
+            const float fraction = (float) i / (float) numFractions;
+            double gain10k, gain15k, delayError, unusedDelayError;
+
+            measureResponse<Interpolator> (10000.0, sampleRate, fraction, gain10k, delayError);
+            measureResponse<Interpolator> (15000.0, sampleRate, fraction, gain15k, unusedDelayError);
+
+            interpolationCase.gainAt10k = juce::jmin (interpolationCase.gainAt10k, gain10k);
+            interpolationCase.gainAt15k = juce::jmin (interpolationCase.gainAt15k, gain15k);
+            interpolationCase.phaseDelayError = juce::jmax (interpolationCase.phaseDelayError, std::abs (delayError));
+        }
+
+        //repetition 0 warms up and is not timed. The fraction moves every read, so Thiran switches pairs as it does in use
+        double fastest = std::numeric_limits<double>::max();
+        float sink = 0;
+
+        for (int repetition = 0; repetition <= repetitions; ++repetition)
+        {
+            StereoFrame<float> output = StereoFrame<float>::expand (0.f), sum = StereoFrame<float>::expand (0.f);
+            float fraction = 0.f;
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            for (int n = 0; n < numReads; ++n)
+            {
+                StereoFrame<float> x[Interpolator::numPoints];
+
+                for (int i = 0; i < Interpolator::numPoints; ++i)
+                    x[i] = StereoFrame<float>::load (input.data() + 2 * (n + i));
+
+                output = Interpolator::process (x, StereoFrame<float>::expand (fraction), output);
+                sum = sum + output;
+
+                fraction += 0.0137f;
+                fraction -= fraction >= 1.f ? 1.f : 0.f;
+            }
+
+            const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+            if (repetition > 0)
+                fastest = juce::jmin (fastest, seconds);
+
+            sink += sum.getLeft() + sum.getRight();
+        }
+
+        interpolationBenchmarkSink = sink;
+        interpolationCase.nsPerRead = fastest * 1.0e9 / numReads;
+    }
+}
+
+juce::String BenchmarkCase::getKey() const
+{
+    return makeKey (Benchmark::getTypeNames()[type], Automation::getPatternNames()[pattern],
+                    Benchmark::getPrecisionNames()[precision], juce::roundToInt (sampleRate), blockSize, numChannels,
+                    Benchmark::getOversamplingNames()[oversampling], Benchmark::getInterpolationNames()[interpolation]);
+}
+
+//==============================================================================
+Benchmark::Benchmark (const BenchmarkOptions& options)
+    : mOptions (options)
+{
+    if (mOptions.types.isEmpty())
+        for (int type = 0; type < ChorusType::numTypes; ++type)
+            mOptions.types.add (type);
+
+    if (mOptions.patterns.isEmpty())
+        for (int pattern = 0; pattern < Automation::numPatterns; ++pattern)
+            mOptions.patterns.add (pattern);
+
+    if (mOptions.precisions.isEmpty())
+        mOptions.precisions = { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision };
+
+    if (mOptions.oversampling.isEmpty())
+        mOptions.oversampling.add (Oversampling::off);
+
+    //the mode --params and --set chose, linear unless they name one
+    if (mOptions.interpolations.isEmpty())
+    {
+        CoolChorusAudioProcessor processor;
+        mOptions.parameters.applyTo (processor);
+
+        auto* interpolationParameter = dynamic_cast<juce::AudioParameterChoice*> (ParameterSettings::findParameter (processor, "interpolation"));
+        mOptions.interpolations.add (interpolationParameter != nullptr ? interpolationParameter->getIndex() : (int) Interpolation::linear);
+    }
+}
+
+juce::StringArray Benchmark::getTypeNames()
+{
+    return { "chorus", "flanger" };
+}
+
+juce::StringArray Benchmark::getPrecisionNames()
+{
+    return { "float", "double" };
+}
+
+juce::StringArray Benchmark::getOversamplingNames()
+{
+    return { "off", "2x", "4x" };
+}
+
+juce::StringArray Benchmark::getInterpolationNames()
+{
+    return { "linear", "hermite", "lagrange", "thiran", "lagrange6" };
+}
+
+juce::String Benchmark::run (std::function<void (const BenchmarkCase&)> onCaseFinished)
+{
+    mCases.clear();
+
+    for (auto type : mOptions.types)
+        for (auto pattern : mOptions.patterns)
+            for (auto precision : mOptions.precisions)
+                for (auto oversampling : mOptions.oversampling)
+                    for (auto interpolation : mOptions.interpolations)
+                        for (auto sampleRate : mOptions.sampleRates)
+                            for (auto blockSize : mOptions.blockSizes)
+                            {
+                                BenchmarkCase benchmarkCase;
+                                benchmarkCase.type = type;
+                                benchmarkCase.pattern = pattern;
+                                benchmarkCase.precision = precision;
+                                benchmarkCase.oversampling = oversampling;
+                                benchmarkCase.interpolation = interpolation;
+                                benchmarkCase.sampleRate = sampleRate;
+                                benchmarkCase.blockSize = blockSize;
+                                benchmarkCase.numChannels = mOptions.numChannels;
+
+                                const juce::String error = precision == juce::AudioProcessor::doublePrecision ? runCase<double> (benchmarkCase)
+                                                                                                             : runCase<float> (benchmarkCase);
+                                if (error.isNotEmpty())
+                                    return error;
+
+                                mCases.push_back (benchmarkCase);
+
+                                if (onCaseFinished != nullptr)
+                                    onCaseFinished (benchmarkCase);
+                            }
+
+    return {};
+}
+
+template <typename SampleType>
+juce::String Benchmark::runCase (BenchmarkCase& benchmarkCase) const
+{
+    CoolChorusAudioProcessor processor;
+
+    const juce::String error = mOptions.parameters.applyTo (processor);
+    if (error.isNotEmpty())
+        return error;
+
+    //the automation goes through setValue, the call a host makes
+    juce::AudioProcessorParameter* typeParameter = ParameterSettings::findParameter (processor, "type");
+    juce::AudioProcessorParameter* depthParameter = ParameterSettings::findParameter (processor, "depth");
+    juce::AudioProcessorParameter* rateParameter = ParameterSettings::findParameter (processor, "rate");
+    juce::AudioProcessorParameter* feedbackParameter = ParameterSettings::findParameter (processor, "feedback");
+    juce::AudioProcessorParameter* dryWetParameter = ParameterSettings::findParameter (processor, "drywet");
+    juce::AudioProcessorParameter* oversamplingParameter = ParameterSettings::findParameter (processor, "oversampling");
+    juce::AudioProcessorParameter* interpolationParameter = ParameterSettings::findParameter (processor, "interpolation");
+
+    if (typeParameter == nullptr || depthParameter == nullptr || rateParameter == nullptr || feedbackParameter == nullptr
+         || dryWetParameter == nullptr || oversamplingParameter == nullptr || interpolationParameter == nullptr)
+        return "The processor is missing one of the automated parameters";
+
+    //the factor is read by prepareToPlay, it and the interpolation override whatever --set gave them. The Render
+    //quality still reads with its own interpolator, see ChorusQuality::getInterpolation
+    oversamplingParameter->setValue ((float) benchmarkCase.oversampling / (float) (Oversampling::numModes - 1));
+    interpolationParameter->setValue ((float) benchmarkCase.interpolation / (float) (Interpolation::numModes - 1));
+
+    const float typeValue = (float) benchmarkCase.type / (float) (ChorusType::numTypes - 1);
+    typeParameter->setValue (typeValue);
+
+    const double sampleRate = benchmarkCase.sampleRate;
+    const int blockSize = benchmarkCase.blockSize;
+    const int numSamples = juce::jmax (blockSize, juce::roundToInt (mOptions.secondsPerRepetition * sampleRate));
+    const int typeSwitchInterval = juce::roundToInt (0.05 * sampleRate);
+
+    const int numChannels = benchmarkCase.numChannels;
+    processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    processor.setProcessingPrecision ((juce::AudioProcessor::ProcessingPrecision) benchmarkCase.precision);
+    processor.prepareToPlay (sampleRate, blockSize);
+    benchmarkCase.bytesPerInstance = processor.getMemoryFootprint();
+
+    juce::AudioBuffer<SampleType> input (numChannels, numSamples);
+    juce::MidiBuffer midiMessages;
+    juce::Random random (0x636f6f6c);
+    juce::Array<double> nsPerSample;
+    double cyclesPerSample = 0;
+
+    //repetition 0 warms up caches and the smoothing, and is not counted
+    for (int repetition = 0; repetition <= mOptions.repetitions; ++repetition)
+    {
+        fillWithNoise (input, random);
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = readCycleCounter();
+
+        for (int position = 0; position < numSamples; position += blockSize)
+        {
+            const int numToProcess = juce::jmin (blockSize, numSamples - position);
+
+            switch (benchmarkCase.pattern)
+            {
+                case Automation::ramp:
+                {
+                    const double phase = std::fmod ((double) position / sampleRate, 1.0);
+                    const float triangle = (float) (phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase);
+                    depthParameter->setValue (triangle);
+                    rateParameter->setValue (triangle);
+                    break;
+                }
+
+                case Automation::jump:
+                    depthParameter->setValue (random.nextFloat());
+                    rateParameter->setValue (random.nextFloat());
+                    feedbackParameter->setValue (random.nextFloat());
+                    dryWetParameter->setValue (random.nextFloat());
+                    break;
+
+                case Automation::typeSwitch:
+                    if ((position / typeSwitchInterval) % 2 == 0)
+                        typeParameter->setValue (typeValue);
+                    else
+                        typeParameter->setValue (1.f - typeValue);
+                    break;
+
+                default:
+                    break;
+            }
+
+            juce::AudioBuffer<SampleType> block (input.getArrayOfWritePointers(), numChannels, position, numToProcess);
+            processor.processBlock (block, midiMessages);
+        }
+
+        const auto cycles = readCycleCounter() - startCycles;
+        const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+        if (repetition == 0)
+            continue;
+
+        nsPerSample.add (seconds * 1.0e9 / numSamples);
+        cyclesPerSample += (double) cycles / numSamples;
+    }
+
+    processor.releaseResources();
+
+    double sum = 0;
+    benchmarkCase.minNsPerSample = nsPerSample.getFirst();
+    benchmarkCase.maxNsPerSample = nsPerSample.getFirst();
+
+    for (auto value : nsPerSample)
+    {
+        sum += value;
+        benchmarkCase.minNsPerSample = juce::jmin (benchmarkCase.minNsPerSample, value);
+        benchmarkCase.maxNsPerSample = juce::jmax (benchmarkCase.maxNsPerSample, value);
+    }
+
+    benchmarkCase.nsPerSample = sum / nsPerSample.size();
+
+    for (auto value : nsPerSample)
+        benchmarkCase.variance += juce::square (value - benchmarkCase.nsPerSample);
+
+    benchmarkCase.variance /= juce::jmax (1, nsPerSample.size() - 1);
+
+   #if JUCE_INTEL
+    benchmarkCase.cyclesPerSample = cyclesPerSample / nsPerSample.size();
+   #else
+    juce::ignoreUnused (cyclesPerSample);
+    benchmarkCase.cyclesPerSample = benchmarkCase.nsPerSample * juce::SystemStats::getCpuSpeedInMegahertz() * 1.0e-3;
+   #endif
+
+    return {};
+}
+
+//==============================================================================
+juce::String Benchmark::loadBaseline (const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return "Baseline " + file.getFullPathName() + " does not exist";
+
+    const juce::var json = juce::JSON::parse (file);
+    const juce::var cases = json["cases"];
+
+    if (! cases.isArray())
+        return file.getFileName() + " is not the output of the bench command";
+
+    mBaseline.clear();
+    mBaselineName = file.getFileName();
+
+    for (auto& baselineCase : *cases.getArray())
+        mBaseline[makeKey (baselineCase["type"].toString(), baselineCase["automation"].toString(),
+                           baselineCase.getProperty ("precision", "float").toString(), //runs from before the double path
+                           (int) baselineCase["sampleRate"], (int) baselineCase["blockSize"],
+                           (int) baselineCase.getProperty ("channels", 2),
+                           baselineCase.getProperty ("oversampling", "off").toString(),
+                           baselineCase["interpolation"].toString())] = (double) baselineCase["nsPerSample"];
+
+    return {};
+}
+
+double Benchmark::getBaselineNsPerSample (const BenchmarkCase& benchmarkCase) const
+{
+    const auto found = mBaseline.find (benchmarkCase.getKey());
+    return found != mBaseline.end() ? found->second : 0.0;
+}
+
+double Benchmark::getWorstRegression() const
+{
+    double worst = 0;
+
+    for (auto& benchmarkCase : mCases)
+    {
+        const double baseline = getBaselineNsPerSample (benchmarkCase);
+
+        if (baseline > 0)
+            worst = juce::jmax (worst, 100.0 * (benchmarkCase.nsPerSample / baseline - 1.0));
+    }
+
+    return worst;
+}
+
+juce::var Benchmark::toJSON() const
+{
+    auto* root = new juce::DynamicObject();
+    juce::var result (root);
+
+    root->setProperty ("plugin", JucePlugin_Name);
+    root->setProperty ("version", JucePlugin_VersionString);
+    root->setProperty ("simd", getSIMDName());
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("cpuMHz", juce::SystemStats::getCpuSpeedInMegahertz());
+   #if JUCE_INTEL
+    root->setProperty ("cycleCounter", "tsc");
+   #else
+    root->setProperty ("cycleCounter", "estimated");
+   #endif
+    root->setProperty ("secondsPerRepetition", mOptions.secondsPerRepetition);
+    root->setProperty ("repetitions", mOptions.repetitions);
+
+    auto* parameters = new juce::DynamicObject();
+    for (int i = 0; i < mOptions.parameters.getIDs().size(); ++i)
+        parameters->setProperty (mOptions.parameters.getIDs()[i], mOptions.parameters.getValues()[i]);
+    root->setProperty ("parameters", juce::var (parameters));
+
+    if (mBaselineName.isNotEmpty())
+        root->setProperty ("baseline", mBaselineName);
+
+    juce::Array<juce::var> cases;
+
+    for (auto& benchmarkCase : mCases)
+    {
+        auto* object = new juce::DynamicObject();
+        object->setProperty ("type", getTypeNames()[benchmarkCase.type]);
+        object->setProperty ("automation", Automation::getPatternNames()[benchmarkCase.pattern]);
+        object->setProperty ("precision", getPrecisionNames()[benchmarkCase.precision]);
+        object->setProperty ("oversampling", getOversamplingNames()[benchmarkCase.oversampling]);
+        object->setProperty ("interpolation", getInterpolationNames()[benchmarkCase.interpolation]);
+        object->setProperty ("sampleRate", juce::roundToInt (benchmarkCase.sampleRate));
+        object->setProperty ("blockSize", benchmarkCase.blockSize);
+        object->setProperty ("channels", benchmarkCase.numChannels);
+        object->setProperty ("nsPerSample", benchmarkCase.nsPerSample);
+        object->setProperty ("minNsPerSample", benchmarkCase.minNsPerSample);
+        object->setProperty ("maxNsPerSample", benchmarkCase.maxNsPerSample);
+        object->setProperty ("variance", benchmarkCase.variance);
+        object->setProperty ("cyclesPerSample", benchmarkCase.cyclesPerSample);
+        object->setProperty ("bytesPerInstance", (juce::int64) benchmarkCase.bytesPerInstance);
+
+        const double baseline = getBaselineNsPerSample (benchmarkCase);
+
+        if (baseline > 0)
+        {
+            object->setProperty ("baselineNsPerSample", baseline);
+            object->setProperty ("speedup", baseline / benchmarkCase.nsPerSample);
+        }
+
+        cases.add (juce::var (object));
+    }
+
+    root->setProperty ("cases", cases);
+    return result;
+}
+
+
+//==============================================================================
+std::vector<LFOBenchmarkCase> LFOBenchmark::run (const juce::Array<int>& trajectoryCounts, float frequency, double sampleRate,
+                                                 int numSamples, int repetitions)
+{
+    std::vector<LFOBenchmarkCase> cases;
+
+    //a rate whose phase step is a power of two, exact in float, so the error measured is the table's alone
+    const float exactStepFrequency = (float) (sampleRate / 32768.0);
+
+    for (auto numTrajectories : trajectoryCounts)
+    {
+        //spread evenly, like the voices of a channel
+        std::vector<float> phaseOffsets;
+
+        for (int k = 0; k < numTrajectories; ++k)
+            phaseOffsets.push_back ((float) k / (float) numTrajectories);
+
+        juce::AudioBuffer<float> output (numTrajectories, LFO_BLOCK_SIZE);
+        auto* const* outputs = output.getArrayOfWritePointers();
+
+        for (int waveform = -1; waveform < ChorusLFO::numWaveforms; ++waveform)
+        {
+            LFOBenchmarkCase lfoCase;
+            lfoCase.waveform = waveform;
+            lfoCase.numTrajectories = numTrajectories;
+
+            const bool measureError = waveform <= ChorusLFO::sineWave;
+            double fastest = std::numeric_limits<double>::max();
+            double maxError = 0;
+            float sink = 0;
+
+            //repetition 0 warms up and is not timed, the error is measured on it at the exact step
+            for (int repetition = 0; repetition <= repetitions; ++repetition)
+            {
+                const float repetitionFrequency = (repetition == 0) ? exactStepFrequency : frequency;
+                const double increment = (double) repetitionFrequency / sampleRate;
+
+                ChorusLFO lfo;
+                lfo.setWaveform (juce::jmax (0, waveform));
+                lfo.setFrequency (repetitionFrequency, (float) sampleRate);
+                double phase = 0;
+
+                const auto startTicks = juce::Time::getHighResolutionTicks();
+
+                for (int position = 0; position < numSamples; position += LFO_BLOCK_SIZE)
+                {
+                    const int blockSize = juce::jmin (LFO_BLOCK_SIZE, numSamples - position);
+                    const double blockPhase = phase;
+
+                    if (waveform < 0)
+                    {
+                        for (int i = 0; i < blockSize; ++i)
+                        {
+                            for (int k = 0; k < numTrajectories; ++k)
+                                outputs[k][i] = (float) std::sin (juce::MathConstants<double>::twoPi * (phase + phaseOffsets[(size_t) k]));
+
+                            phase += increment;
+                            phase -= phase >= 1.0 ? 1.0 : 0.0;
+                        }
+                    }
+                    else
+                    {
+                        lfo.renderBlock (outputs, phaseOffsets.data(), numTrajectories, blockSize);
+                    }
+
+                    sink += outputs[numTrajectories - 1][blockSize - 1];
+
+                    if (repetition == 0 && measureError)
+                    {
+                        double exactPhase = blockPhase;
+
+                        for (int i = 0; i < blockSize; ++i)
+                        {
+                            for (int k = 0; k < numTrajectories; ++k)
+                            {
+                                const double exact = std::sin (juce::MathConstants<double>::twoPi * (exactPhase + phaseOffsets[(size_t) k]));
+                                maxError = juce::jmax (maxError, std::abs ((double) outputs[k][i] - exact));
+                            }
+
+                            exactPhase += increment;
+                            exactPhase -= exactPhase >= 1.0 ? 1.0 : 0.0;
+                        }
+
+                        phase = exactPhase;
+                    }
+                }
+
+                const double seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+                if (repetition > 0)
+                    fastest = juce::jmin (fastest, seconds);
+            }
+
+            lfoBenchmarkSink = sink;
+
+            lfoCase.nsPerValue = fastest * 1.0e9 / ((double) numSamples * numTrajectories);
+            lfoCase.maxError = measureError ? maxError : -1.0;
+            cases.push_back (lfoCase);
+        }
+    }
+
+    return cases;
+}
+
+//==============================================================================
+std::vector<InterpolationBenchmarkCase> InterpolationBenchmark::run (int numReads, int repetitions)
+{
+    //interleaved stereo noise with room for the widest policy past the last read
+    std::vector<float> input ((size_t) (2 * (numReads + 8)));
+    juce::Random random (0x5eed);
+
+    for (auto& sample : input)
+        sample = random.nextFloat() * 2.f - 1.f;
+
+    std::vector<InterpolationBenchmarkCase> cases;
+
+    for (int interpolation = 0; interpolation < Interpolation::numModes; ++interpolation)
+    {
+        InterpolationBenchmarkCase interpolationCase;
+        interpolationCase.interpolation = interpolation;
+
+        switch (interpolation)
+        {
+            case Interpolation::hermite:   measureInterpolator<HermiteInterpolator> (interpolationCase, input, numReads, repetitions); break;
+            case Interpolation::lagrange:  measureInterpolator<LagrangeInterpolator> (interpolationCase, input, numReads, repetitions); break;
+            case Interpolation::thiran:    measureInterpolator<ThiranInterpolator> (interpolationCase, input, numReads, repetitions); break;
+            case Interpolation::lagrange6: measureInterpolator<Lagrange6Interpolator> (interpolationCase, input, numReads, repetitions); break;
+            default:                       measureInterpolator<LinearInterpolator> (interpolationCase, input, numReads, repetitions); break;
+        }
+
+        cases.push_back (interpolationCase);
+    }
+
+    return cases;
+}
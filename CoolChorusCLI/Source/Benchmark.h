@@ -0,0 +1,173 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+
+    Times CoolChorusAudioProcessor::processBlock and the DSP building blocks
+    on synthetic input.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSettings.h"
+
+//==============================================================================
+namespace Automation
+{
+    //How the host moves the parameters while a case runs
+    enum Pattern
+    {
+        none = 0,   //parameters stay where they were set
+        ramp,       //depth and rate follow a one second triangle, updated every block
+        jump,       //depth, rate, feedback and dry/wet jump to random values every block
+        typeSwitch, //Type flips every 50 ms, so the crossfade kernel runs a good part of the time
+        numPatterns
+    };
+
+    inline juce::StringArray getPatternNames()
+    {
+        return { "none", "ramp", "jump", "typeswitch" };
+    }
+}
+
+struct BenchmarkOptions
+{
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    juce::Array<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+    juce::Array<int> types;             //ChorusType values, empty for all of them
+    juce::Array<int> patterns;          //Automation patterns, empty for all of them
+    juce::Array<int> precisions;        //AudioProcessor::ProcessingPrecision values, empty for both
+    juce::Array<int> oversampling;      //Oversampling modes, empty for off only
+    juce::Array<int> interpolations;    //Interpolation modes, empty for the one the parameters set
+    double secondsPerRepetition = 1.0;  //audio processed per timed repetition
+    int repetitions = 7;
+    int numChannels = 2;                //bus width, laid out the way a host would, e.g. 5.1 for 6
+    ParameterSettings parameters;       //applied before the Type and the automation
+};
+
+struct BenchmarkCase
+{
+    int type = 0;
+    int pattern = 0;
+    int precision = juce::AudioProcessor::singlePrecision;
+    int oversampling = 0;
+    int interpolation = 0;
+    double sampleRate = 0;
+    int blockSize = 0;
+    int numChannels = 2;
+
+    //per frame of numChannels samples, over the repetitions
+    double nsPerSample = 0;     //mean
+    double minNsPerSample = 0;
+    double maxNsPerSample = 0;
+    double variance = 0;        //of the per repetition ns/sample, in ns squared
+    double cyclesPerSample = 0;
+
+    size_t bytesPerInstance = 0; //CoolChorusAudioProcessor::getMemoryFootprint() once prepared
+
+    juce::String getKey() const;
+};
+
+//==============================================================================
+/**
+    Sweeps processBlock over block sizes, sample rates, Types, automation
+    patterns, precisions, oversampling factors and interpolation modes.
+
+    Each case gets a fresh processor and an untimed warm-up, then every
+    repetition processes one long noise buffer. Times are per frame of all
+    channels. Cycles come from the time stamp counter on x86 and from the
+    reported CPU speed elsewhere, compare them on the same kind of machine.
+    toJSON()'s output reads back as a baseline.
+*/
+class Benchmark
+{
+public:
+    explicit Benchmark (const BenchmarkOptions& options);
+
+    //Runs every case, calling onCaseFinished after each one
+    juce::String run (std::function<void (const BenchmarkCase&)> onCaseFinished);
+
+    //Reads the cases of an earlier run to compare against
+    juce::String loadBaseline (const juce::File& file);
+
+    //The largest slowdown against the baseline in percent, 0 when nothing got slower
+    double getWorstRegression() const;
+
+    juce::var toJSON() const;
+
+    const std::vector<BenchmarkCase>& getCases() const noexcept { return mCases; }
+
+    //Indexed by ChorusType
+    static juce::StringArray getTypeNames();
+
+    //Indexed by AudioProcessor::ProcessingPrecision
+    static juce::StringArray getPrecisionNames();
+
+    //Indexed by Oversampling::Mode
+    static juce::StringArray getOversamplingNames();
+
+    //Indexed by Interpolation::Mode
+    static juce::StringArray getInterpolationNames();
+
+private:
+    //==============================================================================
+    template <typename SampleType>
+    juce::String runCase (BenchmarkCase& benchmarkCase) const;
+    double getBaselineNsPerSample (const BenchmarkCase& benchmarkCase) const;
+
+    BenchmarkOptions mOptions;
+    std::vector<BenchmarkCase> mCases;
+    std::map<juce::String, double> mBaseline; //ns/sample by BenchmarkCase::getKey()
+    juce::String mBaselineName;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Benchmark)
+};
+
+//==============================================================================
+struct LFOBenchmarkCase
+{
+    int waveform = -1;          //ChorusLFO::Waveform, -1 for sin() called per sample
+    int numTrajectories = 1;
+    double nsPerValue = 0;      //per value of one trajectory, fastest repetition
+    double maxError = -1;       //against sin() in double, for the sine and sin() only
+};
+
+/**
+    Times ChorusLFO::renderBlock for every waveform against the per sample sin()
+    loop it replaced, rendering blocks of LFO_BLOCK_SIZE the way processBlock does.
+    Each count of trajectories is one rendering pass, e.g. 1 for a single voice
+    and 8 for four voices on two channels.
+
+    The sine and sin() are also compared against sin() in double over a warm-up
+    pass, so the measured error can be checked against ChorusLFO::maxSineError.
+*/
+namespace LFOBenchmark
+{
+    std::vector<LFOBenchmarkCase> run (const juce::Array<int>& trajectoryCounts, float frequency, double sampleRate,
+                                       int numSamples, int repetitions);
+}
+
+//==============================================================================
+struct InterpolationBenchmarkCase
+{
+    int interpolation = 0;          //Interpolation::Mode
+    double gainAt10k = 0;           //dB, worst over the fractions
+    double gainAt15k = 0;           //dB, worst over the fractions
+    double phaseDelayError = 0;     //samples at 10 kHz, worst over the fractions
+    double nsPerRead = 0;           //one stereo frame, fastest repetition
+};
+
+/**
+    Measures each interpolation policy on its own, as the quality against cost
+    table for picking a mode. The quality is the level and the phase delay of a
+    steady sine at 48 kHz read at fixed fractions from 0 to 1, worst case over
+    the fractions. The cost is the time per interpolated stereo read while the
+    fraction sweeps.
+*/
+namespace InterpolationBenchmark
+{
+    std::vector<InterpolationBenchmarkCase> run (int numReads, int repetitions);
+}
@@ -0,0 +1,368 @@
+/*
+  ==============================================================================
+
+    GoldenTest.cpp
+
+  ==============================================================================
+*/
+
+#include "GoldenTest.h"
+#include "ReferenceChorus.h"
+
+//==============================================================================
+namespace
+{
+    //Where the silence starts and ends, as fractions of the test signal
+    constexpr double silenceStartFraction = 0.4;
+    constexpr double silenceEndFraction = 0.7;
+
+    //A sweep from 50 Hz to 10 kHz with noise, silence, then a chord of 220 Hz and 3.3 kHz, each channel a little different
+    void fillTestSignal (juce::AudioBuffer<double>& buffer, double sampleRate)
+    {
+        const int numSamples = buffer.getNumSamples();
+        const int sweepEnd = (int) (silenceStartFraction * numSamples);
+        const int silenceEnd = (int) (silenceEndFraction * numSamples);
+        const double sweepSeconds = sweepEnd / sampleRate;
+        const double sweepRatio = std::log (10000.0 / 50.0);
+
+        juce::Random random (0x676f6c64);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            double* const samples = buffer.getWritePointer (channel);
+            const double channelPhase = 0.3 * channel;
+
+            for (int n = 0; n < numSamples; ++n)
+            {
+                const double time = n / sampleRate;
+                double value = 0;
+
+                if (n < sweepEnd)
+                {
+                    //exponential sweep, the phase is the integral of 50 * exp(sweepRatio * t / sweepSeconds)
+                    const double phase = 50.0 * sweepSeconds / sweepRatio * (std::exp (sweepRatio * time / sweepSeconds) - 1.0);
+                    value = 0.4 * std::sin (juce::MathConstants<double>::twoPi * phase + channelPhase) + 0.05 * (2.0 * random.nextDouble() - 1.0);
+                }
+                else if (n >= silenceEnd)
+                {
+                    value = 0.3 * std::sin (juce::MathConstants<double>::twoPi * 220.0 * time + channelPhase)
+                          + 0.3 * std::sin (juce::MathConstants<double>::twoPi * 3300.0 * time);
+                }
+
+                samples[n] = value;
+            }
+        }
+    }
+
+    ChorusParameters getBaseParameters (int interpolation, int waveform)
+    {
+        ChorusParameters parameters;
+        parameters.dryWet = 0.5f;
+        parameters.depth = 0.7f;
+        parameters.rate = 1.3f;
+        parameters.phaseOffset = 0.25f;
+        parameters.feedback = 0.6f;
+        parameters.type = ChorusType::chorus;
+        parameters.waveform = waveform;
+        parameters.numVoices = 3;
+        parameters.interpolation = interpolation;
+        return parameters;
+    }
+
+    //The benchmark's patterns on the engine's own parameters, taken at the start of each block
+    ChorusParameters getAutomatedParameters (const ChorusParameters& base, int pattern, int position, double sampleRate, juce::Random& random)
+    {
+        ChorusParameters parameters = base;
+
+        switch (pattern)
+        {
+            case Automation::ramp:
+            {
+                const double phase = std::fmod ((double) position / sampleRate, 1.0);
+                const float triangle = (float) (phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase);
+                parameters.depth = triangle;
+                parameters.rate = juce::jmap (triangle, 0.1f, 20.f);
+                break;
+            }
+
+            //everything a block can change, voices and phase offset included
+            case Automation::jump:
+                parameters.depth = random.nextFloat();
+                parameters.rate = juce::jmap (random.nextFloat(), 0.1f, 20.f);
+                parameters.feedback = 0.98f * random.nextFloat();
+                parameters.dryWet = random.nextFloat();
+                parameters.phaseOffset = random.nextFloat();
+                parameters.numVoices = 1 + random.nextInt (MAX_VOICES);
+                break;
+
+            case Automation::typeSwitch:
+                if ((position / juce::roundToInt (0.05 * sampleRate)) % 2 == 1)
+                    parameters.type = ChorusType::flanger;
+                break;
+
+            default:
+                break;
+        }
+
+        return parameters;
+    }
+}
+
+//==============================================================================
+//The input of a run, the parameters of each of its blocks and what the reference made of them
+struct GoldenTest::Run
+{
+    ChorusParameters initialParameters;
+    std::vector<ChorusParameters> blockParameters;
+    juce::AudioBuffer<double> input;
+    juce::AudioBuffer<double> reference;
+    int referenceLatency = 0;
+};
+
+juce::String GoldenTestCase::getName() const
+{
+    return juce::String (precision == juce::AudioProcessor::doublePrecision ? "double" : "float") + " "
+         + Benchmark::getInterpolationNames()[interpolation] + " "
+         + Benchmark::getOversamplingNames()[oversampling] + " "
+         + GoldenTest::getWaveformNames()[waveform] + " "
+         + Automation::getPatternNames()[pattern] + " "
+         + juce::String (juce::roundToInt (sampleRate)) + " Hz "
+         + juce::String (blockSize) + " samples";
+}
+
+//==============================================================================
+GoldenTest::GoldenTest (const GoldenTestOptions& options)
+    : mOptions (options)
+{
+    if (mOptions.interpolations.isEmpty())
+        for (int interpolation = 0; interpolation < Interpolation::numModes; ++interpolation)
+            mOptions.interpolations.add (interpolation);
+
+    if (mOptions.oversampling.isEmpty())
+        for (int oversampling = 0; oversampling < Oversampling::numModes; ++oversampling)
+            mOptions.oversampling.add (oversampling);
+
+    if (mOptions.waveforms.isEmpty())
+        for (int waveform = 0; waveform < ChorusLFO::numWaveforms; ++waveform)
+            mOptions.waveforms.add (waveform);
+
+    if (mOptions.patterns.isEmpty())
+        for (int pattern = 0; pattern < Automation::numPatterns; ++pattern)
+            mOptions.patterns.add (pattern);
+
+    if (mOptions.precisions.isEmpty())
+        mOptions.precisions = { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision };
+}
+
+juce::StringArray GoldenTest::getWaveformNames()
+{
+    return { "sine", "triangle", "saw", "random" };
+}
+
+GoldenTest::Tolerance GoldenTest::getTolerance (const GoldenTestCase& testCase)
+{
+    const int waveform = juce::jlimit (0, ChorusLFO::numWaveforms - 1, testCase.waveform);
+
+    //The same for every interpolation and loop rate, what is left is the LFO's tables against the exact shapes
+    static const Tolerance byWaveform[ChorusLFO::numWaveforms] = {
+        { 1.0e-3, 70.0 },   //sine, worst 4.4e-4 and 75.3 dB
+        { 1.0e-4, 90.0 },   //triangle, computed and reads no table, 5.4e-5 and 94.9 dB
+        { 2.0e-3, 66.0 },   //saw, the reset's curve is the table's worst fit, 9.7e-4 and 68.6 dB
+        { 1.0e-3, 70.0 }    //random, 1.6e-4 and 84.0 dB
+    };
+
+    Tolerance tolerance = byWaveform[waveform];
+
+    //without a table error to hide under, the triangle shows float's rounding of the signal, 2.0e-4 and 80.7 dB
+    if (testCase.precision == juce::AudioProcessor::singlePrecision && waveform == ChorusLFO::triangleWave)
+        tolerance = { 4.0e-4, 76.0 };
+
+    return tolerance;
+}
+
+int GoldenTest::getNumFailed() const
+{
+    int numFailed = 0;
+
+    for (auto& testCase : mCases)
+        if (! testCase.passed)
+            ++numFailed;
+
+    return numFailed;
+}
+
+juce::String GoldenTest::run (std::function<void (const GoldenTestCase&)> onCaseFinished)
+{
+    //one run per setting of everything but the precision, the reference renders once for both
+    std::vector<GoldenTestCase> settings;
+
+    for (auto interpolation : mOptions.interpolations)
+        for (auto oversampling : mOptions.oversampling)
+            for (auto waveform : mOptions.waveforms)
+                for (auto pattern : mOptions.patterns)
+                    for (auto sampleRate : mOptions.sampleRates)
+                        for (auto blockSize : mOptions.blockSizes)
+                        {
+                            GoldenTestCase testCase;
+                            testCase.interpolation = interpolation;
+                            testCase.oversampling = oversampling;
+                            testCase.waveform = waveform;
+                            testCase.pattern = pattern;
+                            testCase.sampleRate = sampleRate;
+                            testCase.blockSize = blockSize;
+                            settings.push_back (testCase);
+                        }
+
+    const int numRuns = (int) settings.size();
+    std::vector<std::vector<GoldenTestCase>> results ((size_t) numRuns);
+    std::vector<juce::String> errors ((size_t) numRuns);
+
+    {
+        const int numJobs = mOptions.numJobs > 0 ? mOptions.numJobs : juce::SystemStats::getNumCpus();
+        juce::ThreadPool pool (juce::jmin (numJobs, juce::jmax (1, numRuns)));
+        juce::CriticalSection callbackLock;
+
+        for (int i = 0; i < numRuns; ++i)
+        {
+            pool.addJob ([this, i, &settings, &results, &errors, &onCaseFinished, &callbackLock]
+            {
+                //each job writes only its own slots, so the vectors need no lock
+                errors[(size_t) i] = runOne (settings[(size_t) i], results[(size_t) i]);
+
+                if (onCaseFinished != nullptr)
+                {
+                    const juce::ScopedLock sl (callbackLock);
+
+                    for (auto& testCase : results[(size_t) i])
+                        onCaseFinished (testCase);
+                }
+            });
+        }
+
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep (10);
+    }
+
+    //the cases in the order of the loops above, however the jobs finished
+    mCases.clear();
+
+    for (int i = 0; i < numRuns; ++i)
+    {
+        if (errors[(size_t) i].isNotEmpty())
+            return errors[(size_t) i];
+
+        mCases.insert (mCases.end(), results[(size_t) i].begin(), results[(size_t) i].end());
+    }
+
+    return {};
+}
+
+juce::String GoldenTest::runOne (const GoldenTestCase& settings, std::vector<GoldenTestCase>& cases) const
+{
+    const double sampleRate = settings.sampleRate;
+    const int blockSize = settings.blockSize;
+    const int numSamples = juce::jmax (1, juce::roundToInt (mOptions.seconds * sampleRate));
+    const int factor = Oversampling::getFactor (settings.oversampling);
+
+    Run testRun;
+    testRun.initialParameters = getBaseParameters (settings.interpolation, settings.waveform);
+    testRun.input.setSize (mOptions.numChannels, numSamples);
+    fillTestSignal (testRun.input, sampleRate);
+
+    juce::Random random (0x6a756d70);
+
+    //No feedback from a ramp and a block before the silence to its end, so every precision goes idle on the same block
+    const int silenceStart = (int) (silenceStartFraction * numSamples);
+    const int silenceEnd = (int) (silenceEndFraction * numSamples);
+    const int feedbackOffStart = silenceStart - (int) std::ceil (PARAMETER_RAMP_TIME * sampleRate) - blockSize;
+
+    for (int position = 0; position < numSamples; position += blockSize)
+    {
+        ChorusParameters parameters = getAutomatedParameters (testRun.initialParameters, settings.pattern, position, sampleRate, random);
+
+        if (position >= feedbackOffStart && position < silenceEnd)
+            parameters.feedback = 0;
+
+        testRun.blockParameters.push_back (parameters);
+    }
+
+    ReferenceChorus reference;
+    reference.prepare (sampleRate, mOptions.numChannels, testRun.initialParameters, factor);
+    testRun.referenceLatency = reference.getLatencyInSamples();
+    testRun.reference.makeCopyOf (testRun.input);
+
+    for (int position = 0, block = 0; position < numSamples; position += blockSize, ++block)
+    {
+        double* channels[MAX_CHANNELS];
+
+        for (int channel = 0; channel < mOptions.numChannels; ++channel)
+            channels[channel] = testRun.reference.getWritePointer (channel, position);
+
+        reference.process (testRun.blockParameters[(size_t) block], channels, juce::jmin (blockSize, numSamples - position));
+    }
+
+    for (auto precision : mOptions.precisions)
+    {
+        GoldenTestCase testCase = settings;
+        testCase.precision = precision;
+
+        const juce::String error = precision == juce::AudioProcessor::doublePrecision ? compare<double> (testRun, testCase)
+                                                                                     : compare<float> (testRun, testCase);
+        if (error.isNotEmpty())
+            return error;
+
+        cases.push_back (testCase);
+    }
+
+    return {};
+}
+
+template <typename SampleType>
+juce::String GoldenTest::compare (const Run& testRun, GoldenTestCase& testCase) const
+{
+    const int numChannels = mOptions.numChannels;
+    const int numSamples = testRun.input.getNumSamples();
+    const int blockSize = testCase.blockSize;
+
+    ChorusEngine<SampleType> engine;
+    engine.prepare (testCase.sampleRate, numChannels, testRun.initialParameters, Oversampling::getFactor (testCase.oversampling));
+
+    if (engine.getLatencyInSamples() != testRun.referenceLatency)
+        return testCase.getName() + ": the engine's latency is " + juce::String (engine.getLatencyInSamples())
+             + " samples, the reference's " + juce::String (testRun.referenceLatency);
+
+    juce::AudioBuffer<SampleType> output;
+    output.makeCopyOf (testRun.input);
+
+    for (int position = 0, block = 0; position < numSamples; position += blockSize, ++block)
+    {
+        SampleType* channels[MAX_CHANNELS];
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = output.getWritePointer (channel, position);
+
+        engine.process (testRun.blockParameters[(size_t) block], channels, numChannels, juce::jmin (blockSize, numSamples - position));
+    }
+
+    double signalPower = 0, errorPower = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const double expected = testRun.reference.getSample (channel, n);
+            const double error = (double) output.getSample (channel, n) - expected;
+
+            testCase.maxError = juce::jmax (testCase.maxError, std::abs (error));
+            signalPower += expected * expected;
+            errorPower += error * error;
+        }
+    }
+
+    //a difference of exactly nothing counts as far better than any tolerance
+    testCase.signalToError = (errorPower > 0) ? 10.0 * std::log10 (signalPower / errorPower) : 400.0;
+
+    const Tolerance tolerance = getTolerance (testCase);
+    testCase.passed = testCase.maxError <= tolerance.maxError && testCase.signalToError >= tolerance.minSignalToError;
+    return {};
+}
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+    GoldenTest.h
+
+    Checks the optimised engine against the reference implementation.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Benchmark.h"
+
+//==============================================================================
+struct GoldenTestOptions
+{
+    juce::Array<int> blockSizes { 1, 7, 64, 509, 4096 };
+    juce::Array<double> sampleRates { 44100.0, 96000.0 };
+    juce::Array<int> interpolations;    //Interpolation modes, empty for all of them
+    juce::Array<int> oversampling;      //Oversampling modes, empty for all of them
+    juce::Array<int> waveforms;         //ChorusLFO waveforms, empty for all of them
+    juce::Array<int> patterns;          //Automation patterns, empty for all of them
+    juce::Array<int> precisions;        //AudioProcessor::ProcessingPrecision values, empty for both
+    double seconds = 1.0;               //length of the test signal
+    int numChannels = 2;
+    int numJobs = 0;                    //runs checked at once, 0 for one per core
+};
+
+struct GoldenTestCase
+{
+    int precision = juce::AudioProcessor::singlePrecision;
+    int interpolation = 0;
+    int oversampling = 0;
+    int waveform = 0;
+    int pattern = 0;
+    double sampleRate = 0;
+    int blockSize = 0;
+
+    double maxError = 0;        //largest difference of any sample from the reference
+    double signalToError = 0;   //dB, the reference's power over the power of the difference
+    bool passed = false;
+
+    juce::String getName() const;
+};
+
+//==============================================================================
+/**
+    Renders fixed test signals through ChorusEngine and through ReferenceChorus
+    and fails every case further from the reference than getTolerance().
+
+    The signal is a sweep with noise, silence long enough to go idle and a
+    chord, and the automation is the benchmark's, seeded, so a failure
+    repeats. Both get the same parameters at the same block boundaries.
+*/
+class GoldenTest
+{
+public:
+    explicit GoldenTest (const GoldenTestOptions& options);
+
+    //Runs every case, up to numJobs at once, calling onCaseFinished after each one from
+    //whichever thread ran it, one call at a time. Returns an error if a run could not be compared
+    juce::String run (std::function<void (const GoldenTestCase&)> onCaseFinished);
+
+    const std::vector<GoldenTestCase>& getCases() const noexcept { return mCases; }
+    int getNumFailed() const;
+
+    //The largest peak error and smallest dB the case passes with
+    struct Tolerance
+    {
+        double maxError;
+        double minSignalToError;
+    };
+
+    static Tolerance getTolerance (const GoldenTestCase& testCase);
+
+    //Indexed by ChorusLFO::Waveform
+    static juce::StringArray getWaveformNames();
+
+private:
+    //==============================================================================
+    struct Run;
+
+    //Renders the reference for the settings of one case and compares it with every precision
+    juce::String runOne (const GoldenTestCase& settings, std::vector<GoldenTestCase>& cases) const;
+
+    template <typename SampleType>
+    juce::String compare (const Run& run, GoldenTestCase& testCase) const;
+
+    GoldenTestOptions mOptions;
+    std::vector<GoldenTestCase> mCases;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GoldenTest)
+};
@@ -0,0 +1,782 @@
+/*
+  ==============================================================================
+
+    This file contains the basic startup code for a JUCE application.
+
+    Headless command line tools for CoolChorus, each one a command of a
+    juce::ConsoleApplication. Run with --help for the list.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "Benchmark.h"
+#include "GoldenTest.h"
+#include "../../CoolChorus/Source/PluginProcessor.h"
+
+//==============================================================================
+namespace
+{
+    //Parses --name value as a number, failing the command on anything else
+    template <typename Type>
+    Type getNumberForOption (juce::ArgumentList& args, juce::StringRef option, Type defaultValue, Type minimum)
+    {
+        if (! args.containsOption (option))
+            return defaultValue;
+
+        const juce::String text = args.removeValueForOption (option);
+
+        if (text.isEmpty() || ! text.containsOnly ("0123456789.") || (Type) text.getDoubleValue() < minimum)
+            juce::ConsoleApplication::fail ("Expected a number of at least " + juce::String (minimum) + " for " + option);
+
+        return (Type) text.getDoubleValue();
+    }
+
+    //A parameter file first, then any number of --set id=value on top of it
+    void readParameterOptions (juce::ArgumentList& args, ParameterSettings& parameters)
+    {
+        if (args.containsOption ("--params|-p"))
+        {
+            const juce::File parameterFile = args.getExistingFileForOption ("--params|-p");
+            args.removeValueForOption ("--params|-p");
+
+            const juce::String error = parameters.loadFromFile (parameterFile);
+            if (error.isNotEmpty())
+                juce::ConsoleApplication::fail (error);
+        }
+
+        while (args.containsOption ("--set"))
+        {
+            const juce::String error = parameters.addAssignment (args.removeValueForOption ("--set"));
+            if (error.isNotEmpty())
+                juce::ConsoleApplication::fail (error);
+        }
+    }
+
+    //Parses --name a,b,c into the indices of the names, failing on one that is not in the list
+    juce::Array<int> getNamesForOption (juce::ArgumentList& args, juce::StringRef option, const juce::StringArray& names)
+    {
+        juce::Array<int> indices;
+
+        if (args.containsOption (option))
+        {
+            for (auto& name : juce::StringArray::fromTokens (args.removeValueForOption (option), ",", {}))
+            {
+                const int index = names.indexOf (name.trim(), true);
+
+                if (index < 0)
+                    juce::ConsoleApplication::fail ("Expected one of " + names.joinIntoString (", ") + " for " + option);
+
+                indices.add (index);
+            }
+        }
+
+        return indices;
+    }
+
+    //Parses --name 1,2,3 into numbers, failing on anything that is not positive
+    template <typename Type>
+    juce::Array<Type> getNumbersForOption (juce::ArgumentList& args, juce::StringRef option, const juce::Array<Type>& defaultValues)
+    {
+        if (! args.containsOption (option))
+            return defaultValues;
+
+        juce::Array<Type> values;
+
+        for (auto& text : juce::StringArray::fromTokens (args.removeValueForOption (option), ",", {}))
+        {
+            if (text.isEmpty() || ! text.containsOnly ("0123456789.") || (Type) text.getDoubleValue() <= 0)
+                juce::ConsoleApplication::fail ("Expected a comma separated list of positive numbers for " + option);
+
+            values.add ((Type) text.getDoubleValue());
+        }
+
+        return values;
+    }
+
+    void runRender (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        RenderOptions options;
+        options.blockSize = getNumberForOption (args, "--block-size|-b", options.blockSize, 1);
+        options.numJobs = getNumberForOption (args, "--jobs|-j", options.numJobs, 0);
+        options.tailSeconds = getNumberForOption (args, "--tail", options.tailSeconds, 0.0);
+        options.bpm = getNumberForOption (args, "--bpm", options.bpm, 0.0);
+
+        if (args.containsOption ("--suffix"))
+            options.suffix = args.removeValueForOption ("--suffix");
+
+        if (args.containsOption ("--output|-o"))
+        {
+            options.outputDirectory = args.getFileForOption ("--output|-o");
+            args.removeValueForOption ("--output|-o");
+
+            if (! options.outputDirectory.createDirectory())
+                juce::ConsoleApplication::fail ("Could not create the output directory " + options.outputDirectory.getFullPathName());
+        }
+
+        readParameterOptions (args, options.parameters);
+
+        juce::File traceFile;
+        const bool tracing = args.containsOption ("--trace");
+        const int traceEventsPerThread = getNumberForOption (args, "--trace-events", 1 << 20, 1);
+
+        if (tracing)
+        {
+            traceFile = args.getFileForOption ("--trace");
+            args.removeValueForOption ("--trace");
+
+           #if ! COOLCHORUS_TRACE
+            juce::ConsoleApplication::fail ("This build has no trace zones, build CoolChorusCLI with COOLCHORUS_TRACE=1 to use --trace");
+           #endif
+        }
+
+        juce::Array<juce::File> inputs;
+
+        for (auto& argument : args.arguments)
+        {
+            if (argument.isOption())
+                juce::ConsoleApplication::fail ("Unknown option " + argument.text);
+
+            const juce::File file = argument.resolveAsFile();
+
+            if (file.isDirectory())
+                file.findChildFiles (inputs, juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
+            else
+                inputs.add (file);
+        }
+
+        if (inputs.isEmpty())
+            juce::ConsoleApplication::fail ("No input files");
+
+        OfflineRenderer renderer (options);
+        std::cout << "Rendering " << inputs.size() << " file(s) on " << juce::jmin (renderer.getNumJobs(), inputs.size())
+                  << " thread(s), blocks of " << options.blockSize << " samples" << std::endl;
+
+       #if COOLCHORUS_TRACE
+        //one buffer per worker thread, they are the only ones that process
+        if (tracing)
+            TraceZones::start (renderer.getNumJobs(), traceEventsPerThread);
+       #else
+        juce::ignoreUnused (traceEventsPerThread);
+       #endif
+
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        const auto results = renderer.renderFiles (inputs, [] (const RenderResult& result)
+        {
+            if (result.succeeded())
+                std::cout << "  " << result.output.getFileName() << ": " << juce::String (result.audioSeconds, 1) << " s, "
+                          << juce::String (result.audioSeconds / result.processSeconds, 1) << "x realtime in processBlock, "
+                          << juce::String (result.audioSeconds / result.totalSeconds, 1) << "x with file I/O" << std::endl;
+            else
+                std::cout << "  " << result.input.getFileName() << ": FAILED, " << result.error << std::endl;
+        });
+
+        const double wallSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        double audioSeconds = 0, processSeconds = 0, totalSeconds = 0;
+        int numFailed = 0;
+
+        for (auto& result : results)
+        {
+            audioSeconds += result.audioSeconds;
+            processSeconds += result.processSeconds;
+            totalSeconds += result.totalSeconds;
+            numFailed += result.succeeded() ? 0 : 1;
+        }
+
+        //per core: audio rendered for every second a worker thread spent, the batch figure is what the whole machine did
+        std::cout << "Rendered " << juce::String (audioSeconds, 1) << " s of audio in " << juce::String (wallSeconds, 2) << " s" << std::endl
+                  << "Realtime factor per core: " << juce::String (audioSeconds / juce::jmax (processSeconds, 1e-9), 1) << "x in processBlock, "
+                  << juce::String (audioSeconds / juce::jmax (totalSeconds, 1e-9), 1) << "x with file I/O" << std::endl
+                  << "Realtime factor for the batch: " << juce::String (audioSeconds / juce::jmax (wallSeconds, 1e-9), 1) << "x" << std::endl;
+
+       #if COOLCHORUS_TRACE
+        if (tracing)
+        {
+            TraceZones::stop();
+            traceFile.deleteFile(); //a FileOutputStream appends to what is there
+
+            juce::FileOutputStream stream (traceFile);
+
+            if (! stream.openedOk() || ! TraceZones::writeJSON (stream))
+                juce::ConsoleApplication::fail ("Could not write the trace to " + traceFile.getFullPathName());
+
+            std::cout << "Wrote " << TraceZones::getNumEvents() << " trace events to " << traceFile.getFullPathName() << std::endl;
+
+            if (TraceZones::getNumDropped() > 0)
+                std::cout << TraceZones::getNumDropped() << " more did not fit, raise --trace-events for all of them" << std::endl;
+        }
+       #endif
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail (juce::String (numFailed) + " file(s) failed");
+    }
+
+    void runBench (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        BenchmarkOptions options;
+        options.blockSizes = getNumbersForOption (args, "--block-sizes", options.blockSizes);
+        options.sampleRates = getNumbersForOption (args, "--sample-rates", options.sampleRates);
+        options.types = getNamesForOption (args, "--types", Benchmark::getTypeNames());
+        options.patterns = getNamesForOption (args, "--automation", Automation::getPatternNames());
+        options.precisions = getNamesForOption (args, "--precision", Benchmark::getPrecisionNames());
+        options.oversampling = getNamesForOption (args, "--oversampling", Benchmark::getOversamplingNames());
+        options.interpolations = getNamesForOption (args, "--interpolation", Benchmark::getInterpolationNames());
+        options.secondsPerRepetition = getNumberForOption (args, "--seconds", options.secondsPerRepetition, 0.01);
+        options.repetitions = getNumberForOption (args, "--repetitions|-r", options.repetitions, 1);
+        options.numChannels = juce::jmin (MAX_CHANNELS, getNumberForOption (args, "--channels", options.numChannels, 1));
+        const double maxRegression = getNumberForOption (args, "--max-regression", -1.0, 0.0);
+
+        readParameterOptions (args, options.parameters);
+
+        Benchmark benchmark (options);
+
+        if (args.containsOption ("--baseline"))
+        {
+            const juce::File baselineFile = args.getExistingFileForOption ("--baseline");
+            args.removeValueForOption ("--baseline");
+
+            const juce::String error = benchmark.loadBaseline (baselineFile);
+            if (error.isNotEmpty())
+                juce::ConsoleApplication::fail (error);
+        }
+
+        juce::File outputFile;
+
+        if (args.containsOption ("--output|-o"))
+        {
+            outputFile = args.getFileForOption ("--output|-o");
+            args.removeValueForOption ("--output|-o");
+        }
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        //progress goes to stderr so the JSON on stdout stays clean
+        const juce::String error = benchmark.run ([] (const BenchmarkCase& benchmarkCase)
+        {
+            std::cerr << Benchmark::getTypeNames()[benchmarkCase.type] << " " << Automation::getPatternNames()[benchmarkCase.pattern]
+                      << " " << Benchmark::getPrecisionNames()[benchmarkCase.precision]
+                      << (benchmarkCase.oversampling != Oversampling::off ? " " + Benchmark::getOversamplingNames()[benchmarkCase.oversampling] : juce::String())
+                      << " " << Benchmark::getInterpolationNames()[benchmarkCase.interpolation]
+                      << " " << juce::roundToInt (benchmarkCase.sampleRate) << " Hz, " << benchmarkCase.blockSize << " samples: "
+                      << juce::String (benchmarkCase.nsPerSample, 2) << " ns/sample, "
+                      << juce::String (benchmarkCase.cyclesPerSample, 1) << " cycles/sample, sd "
+                      << juce::String (std::sqrt (benchmarkCase.variance), 2) << " ns" << std::endl;
+        });
+
+        if (error.isNotEmpty())
+            juce::ConsoleApplication::fail (error);
+
+        const juce::String json = juce::JSON::toString (benchmark.toJSON());
+
+        if (outputFile == juce::File())
+            std::cout << json << std::endl;
+        else if (! outputFile.replaceWithText (json))
+            juce::ConsoleApplication::fail ("Could not write " + outputFile.getFullPathName());
+
+        if (maxRegression >= 0 && benchmark.getWorstRegression() > maxRegression)
+            juce::ConsoleApplication::fail ("A case is " + juce::String (benchmark.getWorstRegression(), 1)
+                                              + "% slower than the baseline, more than the allowed " + juce::String (maxRegression, 1) + "%");
+    }
+
+    void runVerify (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        GoldenTestOptions options;
+        options.blockSizes = getNumbersForOption (args, "--block-sizes", options.blockSizes);
+        options.sampleRates = getNumbersForOption (args, "--sample-rates", options.sampleRates);
+        options.interpolations = getNamesForOption (args, "--interpolation", Benchmark::getInterpolationNames());
+        options.oversampling = getNamesForOption (args, "--oversampling", Benchmark::getOversamplingNames());
+        options.waveforms = getNamesForOption (args, "--waveforms", GoldenTest::getWaveformNames());
+        options.patterns = getNamesForOption (args, "--automation", Automation::getPatternNames());
+        options.precisions = getNamesForOption (args, "--precision", Benchmark::getPrecisionNames());
+        options.seconds = getNumberForOption (args, "--seconds", options.seconds, 0.01);
+        options.numChannels = juce::jmin (MAX_CHANNELS, getNumberForOption (args, "--channels", options.numChannels, 1));
+        options.numJobs = getNumberForOption (args, "--jobs|-j", options.numJobs, 0);
+        const bool verbose = args.removeOptionIfFound ("--verbose");
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        GoldenTest goldenTest (options);
+
+        //every failure is printed, the passes only with --verbose
+        const juce::String error = goldenTest.run ([verbose] (const GoldenTestCase& testCase)
+        {
+            if (! verbose && testCase.passed)
+                return;
+
+            const auto tolerance = GoldenTest::getTolerance (testCase);
+
+            std::cout << (testCase.passed ? "  " : "  FAILED ") << testCase.getName() << ": peak error "
+                      << juce::String (testCase.maxError, 7) << " (max " << juce::String (tolerance.maxError, 7) << "), "
+                      << juce::String (testCase.signalToError, 1) << " dB (min " << juce::String (tolerance.minSignalToError, 1) << ")" << std::endl;
+        });
+
+        if (error.isNotEmpty())
+            juce::ConsoleApplication::fail (error);
+
+        const int numFailed = goldenTest.getNumFailed();
+        std::cout << goldenTest.getCases().size() << " case(s) checked against the reference, " << numFailed << " failed" << std::endl;
+
+        if (numFailed > 0)
+            juce::ConsoleApplication::fail (juce::String (numFailed) + " case(s) differ from the reference by more than their tolerance");
+    }
+
+    void runMemory (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        const auto sampleRates = getNumbersForOption (args, "--sample-rates", juce::Array<double> { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 });
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        std::cout << "Per instance, " << (int) sizeof (CoolChorusAudioProcessor) << " bytes of which are the processor object" << std::endl;
+
+        for (auto sampleRate : sampleRates)
+        {
+            CoolChorusAudioProcessor processor;
+            processor.setPlayConfigDetails (2, 2, sampleRate, 512);
+            processor.prepareToPlay (sampleRate, 512);
+
+            std::cout << "  " << juce::roundToInt (sampleRate) << " Hz: "
+                      << juce::String ((double) processor.getMemoryFootprint() / 1024.0, 1) << " KB" << std::endl;
+
+            processor.releaseResources();
+        }
+    }
+
+    //Seconds a call of function takes on each of the processors, the fastest of a few passes over all of them
+    template <typename Function>
+    double timePerInstance (juce::OwnedArray<CoolChorusAudioProcessor>& processors, int repetitions, Function&& function)
+    {
+        double bestSeconds = std::numeric_limits<double>::max();
+
+        for (int repetition = 0; repetition < repetitions; ++repetition)
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+
+            for (auto* processor : processors)
+                function (*processor);
+
+            bestSeconds = juce::jmin (bestSeconds, juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks));
+        }
+
+        return bestSeconds / processors.size();
+    }
+
+    void runStateLoad (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        const int numInstances = getNumberForOption (args, "--instances|-n", 256, 1);
+        const int repetitions = getNumberForOption (args, "--repetitions|-r", 5, 1);
+        const double sampleRate = 48000.0;
+        const int blockSize = 512;
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        //The state of a session's instance, once as the plugin saves it and once as the XML a person would edit
+        juce::MemoryBlock binaryState, xmlState;
+        {
+            CoolChorusAudioProcessor source;
+            source.setCurrentProgram (2);
+            source.getStateInformation (binaryState);
+            juce::AudioProcessor::copyXmlToBinary (*source.createStateXml(), xmlState);
+        }
+
+        //a session load: every instance is made, given its state and prepared
+        juce::OwnedArray<CoolChorusAudioProcessor> processors;
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto* processor = processors.add (new CoolChorusAudioProcessor());
+            processor->setPlayConfigDetails (2, 2, sampleRate, blockSize);
+            processor->setStateInformation (binaryState.getData(), (int) binaryState.getSize());
+            processor->prepareToPlay (sampleRate, blockSize);
+        }
+
+        const double loadSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+        const double binarySeconds = timePerInstance (processors, repetitions, [&] (CoolChorusAudioProcessor& processor)
+        {
+            processor.setStateInformation (binaryState.getData(), (int) binaryState.getSize());
+        });
+
+        const double xmlSeconds = timePerInstance (processors, repetitions, [&] (CoolChorusAudioProcessor& processor)
+        {
+            processor.setStateInformation (xmlState.getData(), (int) xmlState.getSize());
+        });
+
+        juce::MemoryBlock savedState;
+        const double saveSeconds = timePerInstance (processors, repetitions, [&] (CoolChorusAudioProcessor& processor)
+        {
+            processor.getStateInformation (savedState);
+        });
+
+        std::cout << "Loaded " << numInstances << " instances in " << juce::String (loadSeconds * 1000.0, 1) << " ms, "
+                  << juce::String (loadSeconds * 1.0e6 / numInstances, 1) << " us each with construction and prepareToPlay" << std::endl
+                  << "Binary state, " << (int) binaryState.getSize() << " bytes: restore " << juce::String (binarySeconds * 1.0e6, 2)
+                  << " us, save " << juce::String (saveSeconds * 1.0e6, 2) << " us per instance" << std::endl
+                  << "XML state, " << (int) xmlState.getSize() << " bytes: restore " << juce::String (xmlSeconds * 1.0e6, 2)
+                  << " us per instance, " << juce::String (xmlSeconds / juce::jmax (binarySeconds, 1e-12), 1) << "x the binary one" << std::endl;
+    }
+
+    void runPresets (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        juce::File outputDirectory;
+
+        if (args.containsOption ("--output|-o"))
+        {
+            outputDirectory = args.getFileForOption ("--output|-o");
+            args.removeValueForOption ("--output|-o");
+
+            if (! outputDirectory.createDirectory())
+                juce::ConsoleApplication::fail ("Could not create the output directory " + outputDirectory.getFullPathName());
+        }
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        CoolChorusAudioProcessor processor;
+
+        for (int program = 0; program < processor.getNumPrograms(); ++program)
+        {
+            processor.setCurrentProgram (program);
+            std::cout << "  " << program << ": " << processor.getProgramName (program) << std::endl;
+
+            if (outputDirectory == juce::File())
+                continue;
+
+            //the same XML render --params reads
+            const juce::File file = outputDirectory.getChildFile (juce::File::createLegalFileName (processor.getProgramName (program)) + ".xml");
+
+            if (! processor.createStateXml()->writeTo (file))
+                juce::ConsoleApplication::fail ("Could not write " + file.getFullPathName());
+        }
+    }
+
+    //Feeds one block through processBlock the way a host would, parameter changes included
+    template <typename SampleType>
+    void processGuardedBlock (CoolChorusAudioProcessor& processor, juce::AudioBuffer<SampleType>& storage, int numSamples, bool silent, juce::Random& random)
+    {
+        for (int channel = 0; channel < storage.getNumChannels(); ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                storage.setSample (channel, i, silent ? (SampleType) 0 : (SampleType) (random.nextFloat() * 2.0f - 1.0f));
+
+        //hosts may pass any size up to the prepared one, the view over the storage allocates nothing in JUCE but is made outside the section regardless
+        juce::AudioBuffer<SampleType> buffer (storage.getArrayOfWritePointers(), storage.getNumChannels(), numSamples);
+        juce::MidiBuffer midi;
+        auto& parameters = processor.getParameters();
+
+       #if COOLCHORUS_REALTIME_GUARD
+        const RealtimeGuard::ScopedRealtimeSection realtimeSection;
+       #endif
+
+        //a host automating on the audio thread sets parameters there too, a jump of any of them, Type and Oversampling included, and now and
+        //then a program change as VST3 hosts make it
+        parameters[random.nextInt (parameters.size())]->setValue (random.nextFloat());
+
+        if (random.nextInt (50) == 0)
+            processor.setCurrentProgram (random.nextInt (processor.getNumPrograms()));
+        processor.processBlock (buffer, midi);
+    }
+
+    void runRealtimeCheck (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        const int numBlocks = getNumberForOption (args, "--blocks", 2000, 1);
+        const bool failFast = args.removeOptionIfFound ("--fail-fast");
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+       #if ! COOLCHORUS_REALTIME_GUARD
+        juce::ignoreUnused (numBlocks, failFast);
+        juce::ConsoleApplication::fail ("This build has no realtime guard, build CoolChorusCLI with COOLCHORUS_REALTIME_GUARD=1 as its Debug configuration does");
+       #else
+        struct Configuration
+        {
+            double sampleRate;
+            int blockSize;
+            int numChannels;
+            bool doublePrecision;
+            int oversampling;
+        };
+
+        //one processor through all of them, so every prepareToPlay after the first re-enters a prepared processor as a host changing its settings does
+        const Configuration configurations[] = { { 44100.0, 512, 2, false, Oversampling::off },
+                                                 { 48000.0, 64, 1, false, Oversampling::twoTimes },
+                                                 { 96000.0, 2048, 2, true, Oversampling::off },
+                                                 { 48000.0, 256, 6, false, Oversampling::fourTimes },
+                                                 { 192000.0, 128, 12, true, Oversampling::twoTimes },
+                                                 { 44100.0, 1024, 2, false, Oversampling::off } };
+
+        RealtimeGuard::setFailFast (failFast);
+        RealtimeGuard::clearReports();
+
+        CoolChorusAudioProcessor processor;
+        juce::AudioProcessorParameter* oversamplingParameter = ParameterSettings::findParameter (processor, "oversampling");
+        jassert (oversamplingParameter != nullptr);
+        juce::Random random (1);
+
+        for (const auto& configuration : configurations)
+        {
+            oversamplingParameter->setValue ((float) configuration.oversampling / (float) (Oversampling::numModes - 1));
+            processor.setProcessingPrecision (configuration.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                                            : juce::AudioProcessor::singlePrecision);
+            processor.setPlayConfigDetails (configuration.numChannels, configuration.numChannels, configuration.sampleRate, configuration.blockSize);
+            processor.prepareToPlay (configuration.sampleRate, configuration.blockSize);
+
+            juce::AudioBuffer<float> floatStorage (configuration.numChannels, configuration.blockSize);
+            juce::AudioBuffer<double> doubleStorage (configuration.numChannels, configuration.blockSize);
+            const int violationsBefore = RealtimeGuard::getNumViolations();
+
+            for (int block = 0; block < numBlocks; ++block)
+            {
+                const int numSamples = 1 + random.nextInt (configuration.blockSize);
+                const bool silent = (block / 500) % 2 == 1; //long enough for the engine to go idle and wake up again
+
+                if (configuration.doublePrecision)
+                    processGuardedBlock (processor, doubleStorage, numSamples, silent, random);
+                else
+                    processGuardedBlock (processor, floatStorage, numSamples, silent, random);
+            }
+
+            std::cout << juce::roundToInt (configuration.sampleRate) << " Hz, " << configuration.blockSize << " samples, "
+                      << configuration.numChannels << " channel(s), " << (configuration.doublePrecision ? "double" : "float")
+                      << (configuration.oversampling != Oversampling::off ? ", " + Benchmark::getOversamplingNames()[configuration.oversampling] : juce::String()) << ": "
+                      << RealtimeGuard::getNumViolations() - violationsBefore << " violation(s)" << std::endl;
+        }
+
+        processor.releaseResources();
+
+        for (const auto& report : RealtimeGuard::getReports())
+            std::cerr << report << std::endl;
+
+        if (RealtimeGuard::getNumViolations() > 0)
+            juce::ConsoleApplication::fail (juce::String (RealtimeGuard::getNumViolations()) + " allocation(s), lock(s) or sleep(s) on the audio thread");
+       #endif
+    }
+
+    void runLFOBench (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        const auto trajectoryCounts = getNumbersForOption (args, "--trajectories", juce::Array<int> { 1, 8 });
+        const float frequency = getNumberForOption (args, "--rate", 1.3f, 0.01f);
+        const double seconds = getNumberForOption (args, "--seconds", 10.0, 0.01);
+        const int repetitions = getNumberForOption (args, "--repetitions|-r", 7, 1);
+        const double sampleRate = 48000.0;
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        for (auto count : trajectoryCounts)
+            if (count < 1 || count > MAX_CHANNELS * MAX_VOICES)
+                juce::ConsoleApplication::fail ("--trajectories must be between 1 and " + juce::String (MAX_CHANNELS * MAX_VOICES));
+
+        const auto cases = LFOBenchmark::run (trajectoryCounts, frequency, sampleRate, juce::roundToInt (seconds * sampleRate), repetitions);
+
+        std::cout << "LFO at " << frequency << " Hz, " << (int) sampleRate << " Hz sample rate, fastest of " << repetitions
+                  << " passes over " << seconds << " s" << std::endl;
+
+        bool withinBound = true;
+        double sinNsPerValue = 0;
+
+        for (auto& lfoCase : cases)
+        {
+            if (lfoCase.waveform < 0)
+            {
+                sinNsPerValue = lfoCase.nsPerValue;
+                std::cout << lfoCase.numTrajectories << (lfoCase.numTrajectories == 1 ? " trajectory" : " trajectories") << std::endl
+                          << "  sin() per sample  " << juce::String (lfoCase.nsPerValue, 2) << " ns/value";
+            }
+            else
+            {
+                std::cout << "  " << ChorusLFO::getWaveformNames()[lfoCase.waveform].paddedRight (' ', 16)
+                          << juce::String (lfoCase.nsPerValue, 2) << " ns/value, "
+                          << juce::String (sinNsPerValue / juce::jmax (lfoCase.nsPerValue, 1e-12), 1) << "x sin()";
+            }
+
+            if (lfoCase.maxError >= 0)
+                std::cout << ", max error " << lfoCase.maxError;
+
+            if (lfoCase.waveform == ChorusLFO::sineWave)
+            {
+                std::cout << " (bound " << ChorusLFO::maxSineError << ")";
+                withinBound = withinBound && lfoCase.maxError <= ChorusLFO::maxSineError;
+            }
+
+            std::cout << std::endl;
+        }
+
+        if (! withinBound)
+            juce::ConsoleApplication::fail ("The sine is outside its documented error bound");
+    }
+
+    void runInterpolationBench (const juce::ArgumentList& arguments)
+    {
+        juce::ArgumentList args (arguments);
+        args.arguments.remove (0); //the command itself
+
+        const int numReads = getNumberForOption (args, "--reads", 1000000, 1000);
+        const int repetitions = getNumberForOption (args, "--repetitions|-r", 7, 1);
+
+        if (args.size() > 0)
+            juce::ConsoleApplication::fail ("Unexpected argument " + args[0].text);
+
+        const auto cases = InterpolationBenchmark::run (numReads, repetitions);
+
+        std::cout << "Worst case over fractions 0 .. 1 at 48 kHz, cost is the fastest of " << repetitions << " passes over "
+                  << numReads << " stereo reads" << std::endl
+                  << "  Policy        Gain at 10 kHz   Gain at 15 kHz   Phase delay at 10 kHz   Cost" << std::endl;
+
+        for (auto& interpolationCase : cases)
+            std::cout << "  " << Interpolation::getModeNames()[interpolationCase.interpolation].paddedRight (' ', 14)
+                      << (juce::String (interpolationCase.gainAt10k, 1) + " dB").paddedRight (' ', 17)
+                      << (juce::String (interpolationCase.gainAt15k, 1) + " dB").paddedRight (' ', 17)
+                      << ("+/-" + juce::String (interpolationCase.phaseDelayError, 3) + " samples").paddedRight (' ', 24)
+                      << juce::String (interpolationCase.nsPerRead, 2) << " ns/read" << std::endl;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ConsoleApplication app;
+
+    app.addHelpCommand ("--help|-h", "Usage: CoolChorusCLI <command> [options]", true);
+    app.addVersionCommand ("--version|-v", juce::String (ProjectInfo::projectName) + " " + ProjectInfo::versionString);
+
+    app.addCommand ({ "render",
+                      "render [options] <files or directories...>",
+                      "Renders WAV/AIFF files through the chorus",
+                      "Options:\n"
+                      "  --params|-p <file>     parameter values from a .json object or a <PRESET> XML file\n"
+                      "  --set <id>=<value>     sets one parameter, can be repeated, applied after --params\n"
+                      "  --output|-o <dir>      output directory, defaults to next to each input\n"
+                      "  --suffix <text>        appended to each output name, defaults to _chorus\n"
+                      "  --block-size|-b <n>    samples per processBlock call, defaults to 8192\n"
+                      "  --jobs|-j <n>          files rendered at once, defaults to one per core\n"
+                      "  --tail <seconds>       silence rendered after each input, defaults to the plugin's tail length\n"
+                      "  --bpm <n>              plays a transport at this tempo from the start of each input, for --set lfosync=Tempo\n"
+                      "  --trace <file>         writes the processor's trace zones as Chrome trace JSON, needs COOLCHORUS_TRACE=1\n"
+                      "  --trace-events <n>     events kept per thread for --trace, defaults to 1048576\n"
+                      "Values are in the parameter's own units or choice names, e.g. --set rate=2.5 --set lfowaveform=Triangle",
+                      runRender });
+
+    app.addCommand ({ "bench",
+                      "bench [options]",
+                      "Times processBlock over block sizes, sample rates, Types, automation and interpolation, as JSON",
+                      "Options:\n"
+                      "  --block-sizes <n,...>    defaults to 16,32,64,128,256,512,1024,2048,4096\n"
+                      "  --sample-rates <hz,...>  defaults to 44100,48000,96000,192000\n"
+                      "  --types <name,...>       chorus, flanger, defaults to both\n"
+                      "  --automation <name,...>  none, ramp, jump, typeswitch, defaults to all\n"
+                      "  --precision <name,...>   float, double, defaults to both\n"
+                      "  --oversampling <f,...>   off, 2x, 4x, defaults to off\n"
+                      "  --interpolation <m,...>  linear, hermite, lagrange, thiran, lagrange6, defaults to the parameters' mode\n"
+                      "  --seconds <s>            audio processed per repetition, defaults to 1\n"
+                      "  --repetitions|-r <n>     timed repetitions per case, defaults to 7\n"
+                      "  --channels <n>           bus width, 6 is 5.1 and 8 is 7.1, defaults to 2\n"
+                      "  --params|-p, --set       parameter values, as for render\n"
+                      "  --output|-o <file>       writes the JSON to a file instead of stdout\n"
+                      "  --baseline <file>        JSON of an earlier run, adds a speed-up to every matching case\n"
+                      "  --max-regression <pct>   fails when a case is this much slower than the baseline\n"
+                      "Times are per frame of all channels. For a scalar baseline run a build made with COOLCHORUS_USE_SIMD=0.",
+                      runBench });
+
+    app.addCommand ({ "verify",
+                      "verify [options]",
+                      "Checks the engine's output against a plain reference implementation of the same chorus",
+                      "Options:\n"
+                      "  --block-sizes <n,...>      defaults to 1,7,64,509,4096\n"
+                      "  --sample-rates <hz,...>    defaults to 44100,96000\n"
+                      "  --interpolation <name,...> linear, hermite, lagrange, thiran, lagrange6, defaults to all\n"
+                      "  --oversampling <f,...>     off, 2x, 4x, defaults to all\n"
+                      "  --waveforms <name,...>     sine, triangle, saw, random, defaults to all\n"
+                      "  --automation <name,...>    none, ramp, jump, typeswitch, defaults to all\n"
+                      "  --precision <name,...>     float, double, defaults to both\n"
+                      "  --seconds <s>              length of the test signal, defaults to 1\n"
+                      "  --channels <n>             bus width, defaults to 2\n"
+                      "  --jobs|-j <n>              cases checked at once, defaults to one per core\n"
+                      "  --verbose                  prints every case, not only the failures\n"
+                      "Each case renders a sweep, silence and a chord through the engine and through the reference, in double, sample by\n"
+                      "sample, and fails when the peak error or the signal to error ratio is outside the tolerance of its mode.",
+                      runVerify });
+
+    app.addCommand ({ "memory",
+                      "memory [--sample-rates <hz,...>]",
+                      "Prints the memory one plugin instance holds at each sample rate",
+                      "The footprint is the processor object plus its delay line, which is sized for the longest delay of any Type.",
+                      runMemory });
+
+    app.addCommand ({ "rtcheck",
+                      "rtcheck [--blocks <n>] [--fail-fast]",
+                      "Checks that processBlock never allocates, locks or sleeps",
+                      "Runs the processor through parameter jumps, Type switches, program changes, both precisions, several layouts, oversampling\n"
+                      "and repeated prepareToPlay calls, --blocks <n> blocks for each, defaults to 2000, with stretches of silence. Every\n"
+                      "allocation, lock or sleep on the audio thread is printed with its call stack and fails the command, --fail-fast\n"
+                      "aborts on the first one so a debugger stops on it. Needs a build with COOLCHORUS_REALTIME_GUARD=1, as the Debug\n"
+                      "configuration has; link with -rdynamic for function names in the call stacks.",
+                      runRealtimeCheck });
+
+    app.addCommand ({ "stateload",
+                      "stateload [--instances|-n <n>] [--repetitions|-r <n>]",
+                      "Times restoring the state of many instances, as a session load does",
+                      "Makes --instances processors, defaults to 256, from a saved state, then times restoring the binary state, restoring the\n"
+                      "same state from XML and saving it, per instance and the fastest of --repetitions passes, defaults to 5.",
+                      runStateLoad });
+
+    app.addCommand ({ "presets",
+                      "presets [--output|-o <dir>]",
+                      "Lists the factory presets, --output writes each one as a <PRESET> XML file",
+                      "The files are the plugin's XML state, they load with render --params and edit in any text editor.",
+                      runPresets });
+
+    app.addCommand ({ "lfobench",
+                      "lfobench [options]",
+                      "Times the block LFO against calling sin() per sample, and checks the sine against its error bound",
+                      "Options:\n"
+                      "  --trajectories <n,...>   trajectories rendered at once, one per voice and channel, defaults to 1,8\n"
+                      "  --rate <hz>              LFO frequency, defaults to 1.3\n"
+                      "  --seconds <s>            LFO output rendered per repetition, defaults to 10\n"
+                      "  --repetitions|-r <n>     timed repetitions, defaults to 7\n"
+                      "Times are per value of one trajectory. The sine's error against sin() in double is measured on an untimed pass\n"
+                      "with a phase step of exactly 2^-15, and the command fails when it is over the bound ChorusLFO documents.",
+                      runLFOBench });
+
+    app.addCommand ({ "interpbench",
+                      "interpbench [options]",
+                      "Measures the quality and cost of each interpolation mode on its own",
+                      "Options:\n"
+                      "  --reads <n>              interpolated stereo reads timed per repetition, defaults to 1000000\n"
+                      "  --repetitions|-r <n>     timed repetitions, defaults to 7\n"
+                      "Prints the worst gain at 10 and 15 kHz and the worst phase delay error at 10 kHz over the fractions 0 .. 1,\n"
+                      "and the time per read.",
+                      runInterpolationBench });
+
+    return app.findAndRunCommand (juce::ArgumentList (argc, argv), true);
+}
@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "../../CoolChorus/Source/PluginProcessor.h"
+
+//==============================================================================
+namespace
+{
+    //A transport playing from the start of the file at a fixed tempo, moved on by the renderer before every block
+    class RenderPlayHead  : public juce::AudioPlayHead
+    {
+    public:
+        RenderPlayHead (double bpm, double sampleRate) : mBpm (bpm), mSampleRate (sampleRate) {}
+
+        void setPosition (juce::int64 samples) noexcept { mSamples = samples; }
+
+        juce::Optional<PositionInfo> getPosition() const override
+        {
+            const double seconds = (double) mSamples / mSampleRate;
+
+            PositionInfo info;
+            info.setBpm (mBpm);
+            info.setTimeInSamples (mSamples);
+            info.setTimeInSeconds (seconds);
+            info.setPpqPosition (seconds * mBpm / 60.0);
+            info.setIsPlaying (true);
+            return info;
+        }
+
+    private:
+        const double mBpm;
+        const double mSampleRate;
+        juce::int64 mSamples = 0;
+    };
+}
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer (const RenderOptions& options)
+    : mOptions (options),
+      mNumJobs (options.numJobs > 0 ? options.numJobs : juce::SystemStats::getNumCpus())
+{
+    jassert (mOptions.blockSize > 0);
+}
+
+juce::File OfflineRenderer::getOutputFile (const juce::File& input) const
+{
+    const juce::File directory = mOptions.outputDirectory.isDirectory() ? mOptions.outputDirectory
+                                                                         : input.getParentDirectory();
+
+    return directory.getChildFile (input.getFileNameWithoutExtension() + mOptions.suffix + input.getFileExtension());
+}
+
+RenderResult OfflineRenderer::renderFile (const juce::File& input) const
+{
+    RenderResult result;
+    result.input = input;
+    result.output = getOutputFile (input);
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    //Each render has its own format manager, readers and writers are never shared between threads
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    const std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (input));
+
+    if (reader == nullptr)
+    {
+        result.error = "Not a readable audio file";
+        return result;
+    }
+
+    if (reader->numChannels < 1 || reader->numChannels > MAX_CHANNELS)
+    {
+        result.error = "Files with 1 to " + juce::String (MAX_CHANNELS) + " channels are supported, this one has " + juce::String (reader->numChannels) + " channels";
+        return result;
+    }
+
+    if (result.output == input)
+    {
+        result.error = "The output would overwrite the input, use a suffix or another output directory";
+        return result;
+    }
+
+    auto* format = formatManager.findFormatForFileExtension (input.getFileExtension());
+
+    if (format == nullptr || ! format->canDoStereo())
+    {
+        result.error = "No writer for " + input.getFileExtension() + " files";
+        return result;
+    }
+
+    //No editor is ever created, the processor runs on this worker thread only
+    CoolChorusAudioProcessor processor;
+    processor.setNonRealtime (true);
+
+    result.error = mOptions.parameters.applyTo (processor);
+    if (result.error.isNotEmpty())
+        return result;
+
+    const double sampleRate = reader->sampleRate;
+    const int bitsPerSample = format->getPossibleBitDepths().contains ((int) reader->bitsPerSample) ? (int) reader->bitsPerSample : 24;
+
+    result.output.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream (result.output.createOutputStream());
+
+    if (stream == nullptr || stream->failedToOpen())
+    {
+        result.error = "Could not open " + result.output.getFullPathName() + " for writing";
+        return result;
+    }
+
+    //a mono input is fed to both channels of a stereo output, anything wider keeps its channels and the
+    //processor gets the host's default layout for the count, e.g. 5.1 for six channels with the LFE passed through
+    const int numChannels = juce::jmax (2, (int) reader->numChannels);
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), sampleRate, (unsigned int) numChannels, bitsPerSample, reader->metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        result.error = "Could not create a " + format->getFormatName() + " writer";
+        return result;
+    }
+
+    stream.release(); //owned by the writer now
+
+    //the song starts with the file, so a tempo synced LFO comes out the same whatever the block size
+    RenderPlayHead playHead (mOptions.bpm, sampleRate);
+
+    if (mOptions.bpm > 0)
+        processor.setPlayHead (&playHead);
+
+    const int blockSize = mOptions.blockSize;
+    processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    const double tailSeconds = mOptions.tailSeconds >= 0 ? mOptions.tailSeconds : processor.getTailLengthSeconds();
+    const juce::int64 inputLength = reader->lengthInSamples;
+    const juce::int64 outputLength = inputLength + (juce::int64) (tailSeconds * sampleRate);
+
+    //With Oversampling on the output lags, the file starts that many samples in and the processor runs that much longer,
+    //so the output lines up with the input and keeps its whole tail
+    const int latency = processor.getLatencySamples();
+    const juce::int64 totalLength = outputLength + latency;
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+    juce::MidiBuffer midiMessages;
+    juce::int64 processTicks = 0;
+
+    for (juce::int64 position = 0; position < totalLength; position += blockSize)
+    {
+        const int numSamples = (int) juce::jmin ((juce::int64) blockSize, totalLength - position);
+        const int numToRead = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, inputLength - position);
+
+        buffer.setSize (numChannels, numSamples, false, false, true);
+        buffer.clear();
+
+        if (numToRead > 0)
+        {
+            COOLCHORUS_TRACE_ZONE ("Read file");
+            reader->read (&buffer, 0, numToRead, position, true, true);
+
+            if (reader->numChannels == 1)
+                buffer.copyFrom (1, 0, buffer, 0, 0, numToRead);
+        }
+
+        playHead.setPosition (position);
+
+        const auto blockStart = juce::Time::getHighResolutionTicks();
+        processor.processBlock (buffer, midiMessages);
+        processTicks += juce::Time::getHighResolutionTicks() - blockStart;
+
+        const int numToSkip = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, latency - position);
+        bool written = true;
+
+        if (numToSkip < numSamples)
+        {
+            COOLCHORUS_TRACE_ZONE ("Write file");
+            written = writer->writeFromAudioSampleBuffer (buffer, numToSkip, numSamples - numToSkip);
+        }
+
+        if (! written)
+        {
+            writer.reset();
+            result.output.deleteFile();
+            result.error = "Write failed after " + juce::String (juce::jmax ((juce::int64) 0, position - latency)) + " samples";
+            return result;
+        }
+    }
+
+    processor.releaseResources();
+    writer.reset(); //flushes the header
+
+    result.audioSeconds = (double) outputLength / sampleRate;
+    result.processSeconds = juce::Time::highResolutionTicksToSeconds (processTicks);
+    result.totalSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+    return result;
+}
+
+std::vector<RenderResult> OfflineRenderer::renderFiles (const juce::Array<juce::File>& inputs,
+                                                        std::function<void (const RenderResult&)> onFileFinished) const
+{
+    std::vector<RenderResult> results ((size_t) inputs.size());
+    juce::ThreadPool pool (juce::jmin (mNumJobs, juce::jmax (1, inputs.size())));
+    juce::CriticalSection callbackLock;
+
+    for (int i = 0; i < inputs.size(); ++i)
+    {
+        pool.addJob ([this, i, &inputs, &results, &onFileFinished, &callbackLock]
+        {
+            //each job writes only its own slot, so the vector needs no lock
+            results[(size_t) i] = renderFile (inputs.getReference (i));
+
+            if (onFileFinished != nullptr)
+            {
+                const juce::ScopedLock sl (callbackLock);
+                onFileFinished (results[(size_t) i]);
+            }
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (10);
+
+    return results;
+}
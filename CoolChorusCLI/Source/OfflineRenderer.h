@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+    Streams audio files through CoolChorusAudioProcessor without an editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSettings.h"
+
+//==============================================================================
+struct RenderOptions
+{
+    juce::File outputDirectory;          //next to the input when this is not a directory
+    juce::String suffix { "_chorus" };   //appended to the input's name
+    int blockSize = 8192;
+    int numJobs = 0;                     //files rendered at once, 0 for one per core
+    double tailSeconds = -1.0;           //silence rendered after the input, below zero uses the processor's tail length
+    double bpm = 0;                      //tempo of a transport playing from the start of each file, 0 for no play head
+    ParameterSettings parameters;
+};
+
+struct RenderResult
+{
+    juce::File input;
+    juce::File output;
+    juce::String error;
+
+    double audioSeconds = 0;    //length of the rendered output
+    double processSeconds = 0;  //time spent inside processBlock
+    double totalSeconds = 0;    //time for the whole file including decoding and encoding
+
+    bool succeeded() const noexcept { return error.isEmpty(); }
+};
+
+//==============================================================================
+/**
+    Renders audio files through the chorus offline.
+
+    Every file gets its own processor instance, prepared at the file's sample
+    rate and fed in blocks of RenderOptions::blockSize, and the output is written
+    in the input's format and bit depth. renderFiles() runs up to numJobs files at
+    once on a thread pool, one file per job, so a batch scales across cores
+    without any state shared between the processors.
+*/
+class OfflineRenderer
+{
+public:
+    explicit OfflineRenderer (const RenderOptions& options);
+
+    RenderResult renderFile (const juce::File& input) const;
+
+    //Renders every file, calling onFileFinished from the worker thread as each one completes
+    std::vector<RenderResult> renderFiles (const juce::Array<juce::File>& inputs,
+                                           std::function<void (const RenderResult&)> onFileFinished) const;
+
+    int getNumJobs() const noexcept { return mNumJobs; }
+
+private:
+    //==============================================================================
+    juce::File getOutputFile (const juce::File& input) const;
+
+    RenderOptions mOptions;
+    int mNumJobs;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
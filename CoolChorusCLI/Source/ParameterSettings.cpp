@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    ParameterSettings.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterSettings.h"
+
+//==============================================================================
+juce::String ParameterSettings::loadFromFile (const juce::File& file)
+{
+    if (! file.existsAsFile())
+        return "Parameter file " + file.getFullPathName() + " does not exist";
+
+    if (file.hasFileExtension ("json"))
+    {
+        const juce::var json = juce::JSON::parse (file);
+        auto* object = json.getDynamicObject();
+
+        if (object == nullptr)
+            return file.getFileName() + " is not a JSON object of parameter values";
+
+        for (auto& property : object->getProperties())
+        {
+            if (property.value.isObject() || property.value.isArray())
+                return file.getFileName() + ": the value of " + property.name.toString() + " has to be a number or a string";
+
+            set (property.name.toString(), property.value.toString());
+        }
+
+        return {};
+    }
+
+    const std::unique_ptr<juce::XmlElement> xml (juce::XmlDocument::parse (file));
+
+    if (xml == nullptr || ! xml->hasTagName ("PRESET"))
+        return file.getFileName() + " is neither a JSON file nor a <PRESET> XML file";
+
+    for (auto* param : xml->getChildWithTagNameIterator ("PARAM"))
+    {
+        if (! param->hasAttribute ("id") || ! param->hasAttribute ("value"))
+            return file.getFileName() + ": every <PARAM> needs an id and a value";
+
+        set (param->getStringAttribute ("id"), param->getStringAttribute ("value"));
+    }
+
+    return {};
+}
+
+juce::String ParameterSettings::addAssignment (const juce::String& assignment)
+{
+    const juce::String parameterID = assignment.upToFirstOccurrenceOf ("=", false, false).trim();
+    const juce::String value = assignment.fromFirstOccurrenceOf ("=", false, false).trim();
+
+    if (parameterID.isEmpty() || value.isEmpty())
+        return "Expected id=value, got \"" + assignment + "\"";
+
+    set (parameterID, value);
+    return {};
+}
+
+void ParameterSettings::set (const juce::String& parameterID, const juce::String& value)
+{
+    const int index = mIDs.indexOf (parameterID);
+
+    if (index >= 0)
+    {
+        mValues.set (index, value);
+    }
+    else
+    {
+        mIDs.add (parameterID);
+        mValues.add (value);
+    }
+}
+
+juce::String ParameterSettings::applyTo (juce::AudioProcessor& processor) const
+{
+    for (int i = 0; i < mIDs.size(); ++i)
+    {
+        auto* parameter = findParameter (processor, mIDs[i]);
+
+        if (parameter == nullptr)
+        {
+            juce::StringArray knownIDs;
+
+            for (auto* candidate : processor.getParameters())
+                if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (candidate))
+                    knownIDs.add (ranged->getParameterID());
+
+            return "Unknown parameter \"" + mIDs[i] + "\", expected one of " + knownIDs.joinIntoString (", ");
+        }
+
+        const juce::String& text = mValues[i];
+
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*> (parameter))
+        {
+            if (! choice->choices.contains (text))
+                return mIDs[i] + " has no choice \"" + text + "\", expected one of " + choice->choices.joinIntoString (", ");
+        }
+        else
+        {
+            const auto range = parameter->getNormalisableRange();
+
+            if (! text.containsOnly ("0123456789.-+eE") || text.getDoubleValue() < range.start || text.getDoubleValue() > range.end)
+                return mIDs[i] + " expects a number from " + juce::String (range.start) + " to " + juce::String (range.end) + ", got \"" + text + "\"";
+        }
+
+        parameter->setValueNotifyingHost (parameter->getValueForText (text));
+    }
+
+    return {};
+}
+
+juce::RangedAudioParameter* ParameterSettings::findParameter (juce::AudioProcessor& processor, const juce::String& parameterID)
+{
+    for (auto* candidate : processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (candidate))
+            if (ranged->getParameterID() == parameterID)
+                return ranged;
+
+    return nullptr;
+}
@@ -0,0 +1,57 @@
+/*
+  ==============================================================================
+
+    ParameterSettings.h
+
+    Parameter values for offline processing, loaded from files or the command line.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A set of parameter values keyed by parameter ID.
+
+    Values are kept as the text a user would type: a number in the parameter's
+    own range (0.3 for Dry Wet, 12 for Rate in Hz) or the name of a choice
+    ("Triangle" for LFO Waveform). They can come from
+
+      - a JSON object, { "rate": 2.5, "lfowaveform": "Triangle" }
+      - an XML preset, <PRESET><PARAM id="rate" value="2.5"/></PRESET>
+      - id=value assignments given on the command line
+
+    and later values replace earlier ones with the same ID. Every method
+    returns an error message, which is empty on success.
+*/
+class ParameterSettings
+{
+public:
+    ParameterSettings() = default;
+
+    //Reads a .json file or an XML preset
+    juce::String loadFromFile (const juce::File& file);
+
+    //Parses a single id=value assignment
+    juce::String addAssignment (const juce::String& assignment);
+
+    void set (const juce::String& parameterID, const juce::String& value);
+
+    //Checks every ID and value against the processor's parameters and applies them
+    juce::String applyTo (juce::AudioProcessor& processor) const;
+
+    //The processor's parameter with this ID, or nullptr
+    static juce::RangedAudioParameter* findParameter (juce::AudioProcessor& processor, const juce::String& parameterID);
+
+    bool isEmpty() const noexcept { return mIDs.isEmpty(); }
+    const juce::StringArray& getIDs() const noexcept { return mIDs; }
+    const juce::StringArray& getValues() const noexcept { return mValues; }
+
+private:
+    //==============================================================================
+    juce::StringArray mIDs;
+    juce::StringArray mValues;
+};
@@ -0,0 +1,549 @@
+/*
+  ==============================================================================
+
+    ReferenceChorus.cpp
+
+  ==============================================================================
+*/
+
+#include "ReferenceChorus.h"
+
+//==============================================================================
+void ReferenceChorus::Filter::prepare (std::vector<double> impulseResponse)
+{
+    taps = std::move (impulseResponse);
+    history.assign (taps.size() + 2, 0.0);
+}
+
+void ReferenceChorus::Filter::reset()
+{
+    std::fill (history.begin(), history.end(), 0.0);
+}
+
+void ReferenceChorus::Filter::push (double input)
+{
+    history.pop_back();
+    history.insert (history.begin(), input);
+}
+
+double ReferenceChorus::Filter::getOutput (int lag) const
+{
+    double sum = 0;
+
+    for (size_t i = 0; i < taps.size(); ++i)
+        sum += taps[i] * history[(size_t) lag + i];
+
+    return sum;
+}
+
+//==============================================================================
+void ReferenceChorus::prepare (double sampleRate, int numChannels, const ChorusParameters& initialParameters, int oversamplingFactor)
+{
+    jassert (oversamplingFactor == 1 || oversamplingFactor == 2 || oversamplingFactor == 4);
+
+    mSampleRate = sampleRate;
+    mFactor = oversamplingFactor;
+    mLoopRate = sampleRate * oversamplingFactor;
+
+    //Each filter is behind by half its length at its own rate. At 4x the round trip through the second stage is an odd number
+    //of 4x samples, so the first stage's decimator waits one 2x sample more to come back on a whole base sample
+    const int firstDelay = 2 * HalfbandCoefficients::firstStageSize - 1;
+    const int secondDelay = 2 * HalfbandCoefficients::secondStageSize - 1;
+    const int extraDelay = (oversamplingFactor == 4) ? (2 * secondDelay) % 4 / 2 : 0;
+
+    if (oversamplingFactor == 4)
+        mLatency = (2 * (2 * firstDelay + extraDelay) + 2 * secondDelay) / 4;
+    else
+        mLatency = (oversamplingFactor == 2) ? firstDelay : 0;
+
+    mDownExtraDelay = extraDelay;
+
+    mChannels.clear();
+    mChannels.resize ((size_t) juce::jlimit (1, MAX_CHANNELS, numChannels));
+
+    //room for the longest delay and the points an interpolator reads around it
+    const size_t delayLength = (size_t) std::ceil (mLoopRate * ChorusType::maxDelay) + 8;
+
+    for (auto& channel : mChannels)
+    {
+        channel.delayLine.assign (delayLength, 0.0);
+        channel.dryDelay.assign ((size_t) mLatency + 1, 0.0);
+
+        //zero stuffing halves the level, the upsamplers make up for it with a gain of 2
+        channel.upFilters[0].prepare (getHalfbandResponse (HalfbandCoefficients::firstStage, HalfbandCoefficients::firstStageSize, 2.0));
+        channel.upFilters[1].prepare (getHalfbandResponse (HalfbandCoefficients::secondStage, HalfbandCoefficients::secondStageSize, 2.0));
+        channel.downFilters[0].prepare (getHalfbandResponse (HalfbandCoefficients::firstStage, HalfbandCoefficients::firstStageSize, 1.0));
+        channel.downFilters[1].prepare (getHalfbandResponse (HalfbandCoefficients::secondStage, HalfbandCoefficients::secondStageSize, 1.0));
+    }
+
+    mSmoothing[ChorusKernel::type] = 1.0 - std::exp (-1.0 / (ChorusKernel::smoothingTime * mLoopRate));
+    mSmoothing[FlangerKernel::type] = 1.0 - std::exp (-1.0 / (FlangerKernel::smoothingTime * mLoopRate));
+
+    mDryWet.reset (mLoopRate, PARAMETER_RAMP_TIME);
+    mFeedback.reset (mLoopRate, PARAMETER_RAMP_TIME);
+    mDryWet.setCurrentAndTargetValue (initialParameters.dryWet);
+    mFeedback.setCurrentAndTargetValue (initialParameters.feedback);
+
+    mCrossfadeLength = oversamplingFactor * juce::jmax (1, (int) (sampleRate * TYPE_CROSSFADE_TIME));
+    mCrossfadeRemaining = 0;
+    mActiveType = mFadingType = juce::jlimit (0, ChorusType::numTypes - 1, initialParameters.type);
+
+    for (int type = 0; type < ChorusType::numTypes; ++type)
+        resetKernel (type);
+
+    //the saw is scaled to the largest of its values on a 2048 point grid, as the plugin's table is
+    double sawPeak = 0;
+
+    for (int i = 0; i <= 2048; ++i)
+        sawPeak = juce::jmax (sawPeak, std::abs (getSaw (i / 2048.0)));
+
+    mSawPeak = sawPeak;
+
+    mLFOPhase = 0;
+    mLFOCycle = 0;
+    mWritten = 0;
+    mDryWritten = 0;
+
+    //the engine idles once its whole delay line has been quiet
+    mIdleAfterSamples = (int) std::ceil (mLoopRate * ChorusType::maxDelay) + 3;
+    mQuietSamples = 0;
+    mIdle = false;
+}
+
+void ReferenceChorus::process (const ChorusParameters& parameters, double* const* channels, int numSamples)
+{
+    const int numChannels = (int) mChannels.size();
+    const int type = juce::jlimit (0, ChorusType::numTypes - 1, parameters.type);
+    const double phaseIncrement = (double) parameters.rate / mSampleRate;
+
+    bool inputSilent = true;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int n = 0; n < numSamples; ++n)
+            if (std::abs (channels[channel][n]) >= SILENCE_THRESHOLD)
+                inputSilent = false;
+
+    if (mIdle && inputSilent)
+    {
+        if (type != mActiveType)
+            resetKernel (type);
+
+        mActiveType = mFadingType = type;
+        mCrossfadeRemaining = 0;
+        mDryWet.setCurrentAndTargetValue (parameters.dryWet);
+        mFeedback.setCurrentAndTargetValue (parameters.feedback);
+
+        for (int n = 0; n < numSamples; ++n)
+            advanceLFO (phaseIncrement);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            std::fill (channels[channel], channels[channel] + numSamples, 0.0);
+
+        return;
+    }
+
+    mIdle = false;
+
+    if (type != mActiveType)
+    {
+        if (mCrossfadeRemaining > 0)
+        {
+            mCrossfadeRemaining = mCrossfadeLength - mCrossfadeRemaining;
+        }
+        else
+        {
+            resetKernel (type);
+            mCrossfadeRemaining = mCrossfadeLength;
+        }
+
+        mFadingType = mActiveType;
+        mActiveType = type;
+    }
+
+    mDryWet.setTargetValue (parameters.dryWet);
+    mFeedback.setTargetValue (parameters.feedback);
+
+    const int numVoices = juce::jlimit (1, MAX_VOICES, parameters.numVoices);
+
+    //voice v of channel c runs v / numVoices + phaseOffset * c / (numChannels - 1) of a cycle ahead of the oscillator
+    double offsets[MAX_CHANNELS][MAX_VOICES];
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        for (int voice = 0; voice < numVoices; ++voice)
+        {
+            const double channelOffset = (numChannels > 1) ? (double) parameters.phaseOffset * channel / (numChannels - 1) : 0.0;
+            const double offset = (double) voice / numVoices + channelOffset;
+            offsets[channel][voice] = (offset >= 1.0) ? offset - 1.0 : offset;
+        }
+    }
+
+    double lfo[MAX_CHANNELS][MAX_VOICES];
+    double loopInput[MAX_CHANNELS][4];
+    double loopWet[MAX_CHANNELS][4];
+    double writePeak = 0;
+
+    for (int n = 0; n < numSamples; ++n)
+    {
+        //the LFO runs at the base rate and holds its values for the loop
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int voice = 0; voice < numVoices; ++voice)
+                lfo[channel][voice] = getLFOValue (parameters.waveform, offsets[channel][voice]);
+
+        advanceLFO (phaseIncrement);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            if (mFactor > 1)
+                upsample (mChannels[(size_t) channel], channels[channel][n], loopInput[channel]);
+            else
+                loopInput[channel][0] = channels[channel][n];
+        }
+
+        double dryGain = 0, wetGain = 0;
+
+        for (int k = 0; k < mFactor; ++k)
+        {
+            const double dryWet = mDryWet.getNextValue();
+            const double voiceFeedback = mFeedback.getNextValue() / numVoices;
+
+            //an oversampled block mixes at the base rate with the gains of the first loop sample of each base sample
+            if (k == 0)
+            {
+                dryGain = 1.0 - dryWet;
+                wetGain = dryWet / std::sqrt ((double) numVoices);
+            }
+
+            const bool crossfading = mCrossfadeRemaining > 0;
+            const double fadeIn = 1.0 - (double) mCrossfadeRemaining / mCrossfadeLength;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                Channel& state = mChannels[(size_t) channel];
+                const double input = loopInput[channel][k];
+                const double active = readVoices (state, mActiveType, parameters, numVoices, lfo[channel]);
+                const double write = input + state.feedback;
+
+                if (crossfading)
+                {
+                    const double fading = readVoices (state, mFadingType, parameters, numVoices, lfo[channel]);
+
+                    state.feedback = (active * fadeIn * getFeedbackSign (mActiveType) + fading * (1.0 - fadeIn) * getFeedbackSign (mFadingType)) * voiceFeedback;
+                    loopWet[channel][k] = active * fadeIn + fading * (1.0 - fadeIn);
+                }
+                else
+                {
+                    state.feedback = active * getFeedbackSign (mActiveType) * voiceFeedback;
+                    loopWet[channel][k] = active;
+                }
+
+                state.delayLine[(size_t) (mWritten % (juce::int64) state.delayLine.size())] = write;
+
+                if (inputSilent)
+                    writePeak = juce::jmax (writePeak, std::abs (write));
+
+                if (mFactor == 1)
+                    channels[channel][n] = input * (1.0 - dryWet) + loopWet[channel][k] * dryWet / std::sqrt ((double) numVoices);
+            }
+
+            ++mWritten;
+
+            if (crossfading)
+                --mCrossfadeRemaining;
+        }
+
+        if (mFactor > 1)
+        {
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                Channel& state = mChannels[(size_t) channel];
+                const double wet = downsample (state, loopWet[channel]);
+
+                //the ring is one longer than the latency, the frame read is the oldest in it
+                const juce::int64 dryLength = (juce::int64) state.dryDelay.size();
+                state.dryDelay[(size_t) (mDryWritten % dryLength)] = channels[channel][n];
+                const double dry = state.dryDelay[(size_t) ((mDryWritten + dryLength - mLatency) % dryLength)];
+
+                channels[channel][n] = dry * dryGain + wet * wetGain;
+            }
+
+            ++mDryWritten;
+        }
+    }
+
+    if (inputSilent && writePeak < SILENCE_THRESHOLD)
+        mQuietSamples += numSamples * mFactor;
+    else
+        mQuietSamples = 0;
+
+    if (mQuietSamples >= mIdleAfterSamples)
+        enterIdle();
+}
+
+//==============================================================================
+void ReferenceChorus::advanceLFO (double phaseIncrement)
+{
+    mLFOPhase += phaseIncrement;
+
+    if (mLFOPhase >= 1.0)
+    {
+        mLFOPhase -= 1.0;
+        ++mLFOCycle;
+    }
+}
+
+double ReferenceChorus::getLFOValue (int waveform, double offset) const
+{
+    double phase = mLFOPhase + offset;
+    juce::int64 cycle = mLFOCycle;
+
+    if (phase >= 1.0)
+    {
+        phase -= 1.0;
+        ++cycle;
+    }
+
+    switch (waveform)
+    {
+        case ChorusLFO::triangleWave:
+        {
+            //a quarter cycle on, so it starts at zero and rises like the sine
+            const double shifted = (phase + 0.25 >= 1.0) ? phase - 0.75 : phase + 0.25;
+            return 1.0 - 4.0 * std::abs (shifted - 0.5);
+        }
+
+        case ChorusLFO::sawWave:
+            return getSaw (phase) / mSawPeak;
+
+        case ChorusLFO::randomWave:
+        {
+            //a raised cosine from the target of this cycle to the next one's
+            const double glide = 0.5 - 0.5 * std::cos (juce::MathConstants<double>::pi * phase);
+            const double from = getRandomTarget (cycle);
+            return from + glide * (getRandomTarget (cycle + 1) - from);
+        }
+
+        default:
+            return std::sin (juce::MathConstants<double>::twoPi * phase);
+    }
+}
+
+double ReferenceChorus::getSaw (double phase) const
+{
+    //the first 8 harmonics of a falling saw with Lanczos sigma factors
+    const int numHarmonics = 8;
+    double value = 0;
+
+    for (int k = 1; k <= numHarmonics; ++k)
+    {
+        const double sigmaArgument = juce::MathConstants<double>::pi * k / (numHarmonics + 1);
+        value -= std::sin (sigmaArgument) / sigmaArgument * std::sin (juce::MathConstants<double>::twoPi * k * phase) / k;
+    }
+
+    return value;
+}
+
+double ReferenceChorus::getRandomTarget (juce::int64 cycle)
+{
+    //the LFO starts from 0, every later cycle's target is a hash of its number
+    if (cycle == 0)
+        return 0.0;
+
+    juce::uint32 x = (juce::uint32) cycle * 0x9e3779b9u + 0x2545f491u;
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return (double) (x >> 8) / 8388608.0 - 1.0;
+}
+
+double ReferenceChorus::readVoices (Channel& channel, int type, const ChorusParameters& parameters, int numVoices, const double* lfo)
+{
+    const bool flanger = (type == ChorusType::flanger);
+    const double minDelay = flanger ? FlangerKernel::minDelay : ChorusKernel::minDelay;
+    const double maxDelay = flanger ? FlangerKernel::maxDelay : ChorusKernel::maxDelay;
+    const double centre = 0.5 * (minDelay + maxDelay);
+    const double swing = 0.5 * (maxDelay - minDelay) * parameters.depth;
+    double sum = 0;
+
+    for (int voice = 0; voice < numVoices; ++voice)
+    {
+        double& delayTime = channel.delayTime[type][voice];
+        delayTime += mSmoothing[type] * (centre + lfo[voice] * swing - delayTime);
+
+        //the read is delaySamples behind the frame about to be written, between frame x0 and x0 + 1 at fraction t
+        const double delaySamples = delayTime * mLoopRate;
+        const int wholeSamples = (int) delaySamples;
+        const double t = 1.0 - (delaySamples - wholeSamples);
+        const juce::int64 x0 = mWritten - wholeSamples - 1;
+
+        double& output = channel.interpolatorOutput[type][voice];
+        output = interpolate (channel, parameters.interpolation, x0, t, output);
+        sum += output;
+    }
+
+    return sum;
+}
+
+double ReferenceChorus::interpolate (const Channel& channel, int interpolation, juce::int64 x0, double t, double previousOutput) const
+{
+    const juce::int64 size = (juce::int64) channel.delayLine.size();
+    const auto x = [&] (int i) { return channel.delayLine[(size_t) (((x0 + i) % size + size) % size)]; };
+
+    //the polynomial through frames first .. last, weight j is the product over k != j of (t - k) / (j - k)
+    const auto lagrange = [&] (int first, int last)
+    {
+        double sum = 0;
+
+        for (int j = first; j <= last; ++j)
+        {
+            double weight = 1;
+
+            for (int k = first; k <= last; ++k)
+                if (k != j)
+                    weight *= (t - k) / (double) (j - k);
+
+            sum += weight * x (j);
+        }
+
+        return sum;
+    };
+
+    switch (interpolation)
+    {
+        case Interpolation::hermite:
+        {
+            //Catmull-Rom, the cubic with the central differences as its slopes at x0 and x1
+            const double t2 = t * t, t3 = t2 * t;
+            return 0.5 * ((-t3 + 2.0 * t2 - t) * x (-1) + (3.0 * t3 - 5.0 * t2 + 2.0) * x (0)
+                          + (-3.0 * t3 + 4.0 * t2 + t) * x (1) + (t3 - t2) * x (2));
+        }
+
+        case Interpolation::lagrange:
+            return lagrange (-1, 2);
+
+        case Interpolation::lagrange6:
+            return lagrange (-2, 3);
+
+        case Interpolation::thiran:
+        {
+            //first order allpass y = older + eta (newer - previous y), eta = (1 - D) / (1 + D), on x0/x1 with D = 1 - t
+            //and on x1/x2 with D = 2 - t, mixed in proportion from t = 0.282 to 0.482. It is x0 at t = 0 and x1 at t = 1,
+            //so the output is continuous in the delay, across a change of its whole part as well
+            const double lowerDelay = 1.0 - t, upperDelay = 2.0 - t;
+            const double lower = x (0) + (1.0 - lowerDelay) / (1.0 + lowerDelay) * (x (1) - previousOutput);
+            const double upper = x (1) + (1.0 - upperDelay) / (1.0 + upperDelay) * (x (2) - previousOutput);
+            const double blend = juce::jlimit (0.0, 1.0, (t - 0.282) / 0.2);
+            return lower + blend * (upper - lower);
+        }
+
+        default:
+            return lagrange (0, 1);
+    }
+}
+
+void ReferenceChorus::upsample (Channel& channel, double input, double* output)
+{
+    //each input is followed by a zero, the filter fills the gaps
+    double twice[2];
+
+    for (int i = 0; i < 2; ++i)
+    {
+        channel.upFilters[0].push (i == 0 ? input : 0.0);
+        twice[i] = channel.upFilters[0].getOutput (0);
+    }
+
+    if (mFactor == 2)
+    {
+        output[0] = twice[0];
+        output[1] = twice[1];
+        return;
+    }
+
+    for (int i = 0; i < 4; ++i)
+    {
+        channel.upFilters[1].push (i % 2 == 0 ? twice[i / 2] : 0.0);
+        output[i] = channel.upFilters[1].getOutput (0);
+    }
+}
+
+double ReferenceChorus::downsample (Channel& channel, const double* input)
+{
+    //the filter runs on every input and every other output is kept, the earlier one of each pair, lag 1 from the newest
+    if (mFactor == 2)
+    {
+        channel.downFilters[0].push (input[0]);
+        channel.downFilters[0].push (input[1]);
+        return channel.downFilters[0].getOutput (1);
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+        channel.downFilters[1].push (input[2 * i]);
+        channel.downFilters[1].push (input[2 * i + 1]);
+        channel.downFilters[0].push (channel.downFilters[1].getOutput (1));
+    }
+
+    return channel.downFilters[0].getOutput (1 + mDownExtraDelay);
+}
+
+void ReferenceChorus::resetKernel (int type)
+{
+    const double centre = (type == ChorusType::flanger) ? 0.5 * ((double) FlangerKernel::minDelay + FlangerKernel::maxDelay)
+                                                        : 0.5 * ((double) ChorusKernel::minDelay + ChorusKernel::maxDelay);
+
+    for (auto& channel : mChannels)
+    {
+        for (int voice = 0; voice < MAX_VOICES; ++voice)
+        {
+            channel.delayTime[type][voice] = centre;
+            channel.interpolatorOutput[type][voice] = 0;
+        }
+    }
+}
+
+void ReferenceChorus::enterIdle()
+{
+    for (auto& channel : mChannels)
+    {
+        std::fill (channel.delayLine.begin(), channel.delayLine.end(), 0.0);
+        std::fill (channel.dryDelay.begin(), channel.dryDelay.end(), 0.0);
+        channel.feedback = 0;
+
+        for (auto& filter : channel.upFilters)
+            filter.reset();
+
+        for (auto& filter : channel.downFilters)
+            filter.reset();
+
+        for (int type = 0; type < ChorusType::numTypes; ++type)
+            for (int voice = 0; voice < MAX_VOICES; ++voice)
+                channel.interpolatorOutput[type][voice] = 0;
+    }
+
+    mQuietSamples = 0;
+    mIdle = true;
+}
+
+double ReferenceChorus::getFeedbackSign (int type)
+{
+    return (type == ChorusType::flanger) ? FlangerKernel::feedbackSign : ChorusKernel::feedbackSign;
+}
+
+std::vector<double> ReferenceChorus::getHalfbandResponse (const double* sideTaps, int numSideTaps, double gain)
+{
+    //4 numSideTaps - 1 taps, 0.5 in the centre, the side taps on the odd distances from it and zeros on the even ones
+    const int centre = 2 * numSideTaps - 1;
+    std::vector<double> response ((size_t) (2 * centre + 1), 0.0);
+
+    response[(size_t) centre] = 0.5 * gain;
+
+    for (int i = 0; i < numSideTaps; ++i)
+    {
+        response[(size_t) (centre + 2 * i + 1)] = sideTaps[i] * gain;
+        response[(size_t) (centre - 2 * i - 1)] = sideTaps[i] * gain;
+    }
+
+    return response;
+}
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    ReferenceChorus.h
+
+    The chorus written out sample by sample, to check the engine against.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../../CoolChorus/Source/ChorusEngine.h"
+
+//==============================================================================
+/**
+    ChorusEngine's algorithm written the slow and obvious way, in double, one
+    sample and one channel at a time, sharing only the constants that define
+    the sound: sin() and summed harmonics for the LFO, a modulo ring for the
+    delay line, textbook interpolator weights and full half-band convolutions.
+
+    What the engine does once per process() call, taking the parameters,
+    starting ramps and a change of Type and going idle, the reference does at
+    the same calls.
+*/
+class ReferenceChorus
+{
+public:
+    ReferenceChorus() = default;
+
+    //Clears everything and starts settled on initialParameters, like ChorusEngine::prepare
+    void prepare (double sampleRate, int numChannels, const ChorusParameters& initialParameters, int oversamplingFactor);
+
+    //channels holds the numChannels channels given to prepare(), each numSamples long, processed in place
+    void process (const ChorusParameters& parameters, double* const* channels, int numSamples);
+
+    //Samples the output lags the input by, worked out from the filters' lengths
+    int getLatencyInSamples() const noexcept { return mLatency; }
+
+private:
+    //==============================================================================
+    //A linear phase FIR over a history of its input, newest first
+    struct Filter
+    {
+        void prepare (std::vector<double> impulseResponse);
+        void reset();
+        void push (double input);
+
+        //The output for the input pushed lag samples ago
+        double getOutput (int lag) const;
+
+        std::vector<double> taps;
+        std::vector<double> history;
+    };
+
+    struct Channel
+    {
+        std::vector<double> delayLine; //every frame written, at delayLine[index % size]
+        double feedback = 0;
+
+        double delayTime[ChorusType::numTypes][MAX_VOICES] = {};      //seconds, after the one pole
+        double interpolatorOutput[ChorusType::numTypes][MAX_VOICES] = {};
+
+        //only used when oversampling, the first stage is nearest the base rate
+        Filter upFilters[2];
+        Filter downFilters[2];
+        std::vector<double> dryDelay;
+    };
+
+    void advanceLFO (double phaseIncrement);
+    double getLFOValue (int waveform, double offset) const;
+    double getSaw (double phase) const;
+
+    //Smooths the delay of every voice of one Type towards its LFO value and returns the sum of their reads
+    double readVoices (Channel& channel, int type, const ChorusParameters& parameters, int numVoices, const double* lfo);
+    double interpolate (const Channel& channel, int interpolation, juce::int64 x0, double t, double previousOutput) const;
+
+    //One base sample in, mFactor loop samples out, and back
+    void upsample (Channel& channel, double input, double* output);
+    double downsample (Channel& channel, const double* input);
+
+    void resetKernel (int type);
+    void enterIdle();
+
+    static double getRandomTarget (juce::int64 cycle);
+    static double getFeedbackSign (int type);
+    static std::vector<double> getHalfbandResponse (const double* sideTaps, int numSideTaps, double gain);
+
+    //==============================================================================
+    std::vector<Channel> mChannels;
+    juce::int64 mWritten = 0; //frames written to every delay line, at the loop's rate
+    juce::int64 mDryWritten = 0;
+
+    double mSampleRate = 0;
+    double mLoopRate = 0;
+    int mFactor = 1;
+    int mLatency = 0;
+    int mDownExtraDelay = 0; //2x samples the first stage's decimator waits at 4x
+
+    double mLFOPhase = 0;
+    juce::int64 mLFOCycle = 0; //whole cycles run since the start, the random shape's targets are numbered by them
+    double mSawPeak = 1;
+
+    juce::SmoothedValue<double> mDryWet;
+    juce::SmoothedValue<double> mFeedback;
+    double mSmoothing[ChorusType::numTypes] = {};
+
+    int mActiveType = 0;
+    int mFadingType = 0;
+    int mCrossfadeLength = 1;
+    int mCrossfadeRemaining = 0;
+
+    int mIdleAfterSamples = 0;
+    int mQuietSamples = 0;
+    bool mIdle = false;
+
+    JUCE_DECLARE_NON_COPYABLE (ReferenceChorus)
+};